@@ -3,26 +3,43 @@
 
 #include "Gold_notify.hpp"
 
-Inst_id Gold_core::global_instid;
+Gold_core::Gold_core(Gold_mem &m, int id, size_t rob_size) : mem(m), rob_head(1), rob_next(1), cid(id) {
+    size_t size = 1;
+    while (size < rob_size) size <<= 1;
 
-Gold_core::Gold_core(Gold_mem &m, int id) : mem(m), cid(id) {}
+    rob.resize(size);
+    rob_mask = size - 1;
+}
 
 Inst_id Gold_core::inorder() {
-    global_instid = global_instid + 1;
-    auto i        = global_instid;
+    if (rob_next - rob_head > rob_mask) {
+        dump();
+        Gold_nofity::fail("core:{} more than {} instructions in flight, oldest id:{}", cid, rob_mask + 1, rob_head);
+        exit(-3);
+    }
 
-    rob.push_front({i});
+    Inst_id i = rob_next;
+    rob_next  = rob_next + 1;
 
-    assert(rob.front().rid == i);
-    assert(rob.front().op == Mem_op::Invalid);
+    rob[i & rob_mask].reset(i);
+
+    assert(find_rob(i));
+    assert(find_rob(i)->op == Mem_op::Invalid);
 
     return i;
 }
 
+void Gold_core::drop(Inst_id iid) {
+    if (auto *e = find_rob(iid))
+        e->valid = false;
+
+    while (rob_head < rob_next && !rob[rob_head & rob_mask].valid) rob_head = rob_head + 1;
+}
+
 void Gold_core::set_type(Inst_id iid, Mem_op op) {
-    auto it = std::find_if(rob.begin(), rob.end(), [&iid](const Rob_entry &x) { return x.rid == iid; });
+    auto *it = find_rob(iid);
 
-    if (it == rob.end()) {
+    if (!it) {
         return;  // may be nuked
     }
 
@@ -42,31 +59,31 @@ void Gold_core::nuke(Inst_id iid) {
         return;
     }
 
-    if (rob.empty())
-        return;
+    // Youngest first, the ids are not handed out again
+    for (Inst_id id = rob_next - 1; id >= rob_head && id >= iid; id = id - 1) {
+        auto *e = find_rob(id);
+        if (!e)
+            continue;
 
-    while (rob.front().rid >= iid) {
-        const auto &e = rob.front();
-        std::cout << "nuke: rid:" << e.rid << " error:" << e.error << "\n";
-        e.dump("rob");
+        std::cout << "nuke: rid:" << e->rid << " error:" << e->error << "\n";
+        e->dump("rob");
 
-        rob.pop_front();
-        if (rob.empty())
-            return;
+        e->valid = false;
     }
+    drop(0);
 }
 
 Gold_core::Rob_entry &Gold_core::find_entry(Inst_id iid) {
-    auto rob_it = std::find_if(rob.begin(), rob.end(), [&iid](const Rob_entry &x) { return x.rid == iid; });
+    auto *e = find_rob(iid);
 
-    if (rob_it == rob.end()) {
+    if (!e) {
         dump();
         std::cout << "WARNING: iid:" << iid << " must be in ROB\n";
         static Rob_entry inv(0);
         return inv;
     }
 
-    return *rob_it;
+    return *e;
 }
 
 Gold_data &Gold_core::ld_data_ref(Inst_id iid) { return find_entry(iid).ld_data; }
@@ -84,18 +101,12 @@ const Gold_data &Gold_core::ld_perform(Inst_id iid) {
 
     mem.ld_perform(ent.ld_data);
 
-    if (rob.back().rid != iid) {  // Not if load is the oldest in ROB
-
-        Rob_queue::reverse_iterator rob_end
-            = std::find_if(rob.rbegin(), rob.rend(), [&iid](const Rob_entry &x) { return x.rid == iid; });
-        assert(rob_end != rob.rend());
-
-        for (auto it = rob.rbegin(); it != rob_end; ++it) {
-            assert(it->rid < iid);
-            if (it->st_data.has_data()) {
-                Gold_nofity::info("ld iid:{} fwd from st iid:{}", iid, it->rid);
-                ent.ld_data.update_newer(it->st_data);
-            }
+    // Forward from the older stores still in flight, oldest first
+    for (Inst_id id = rob_head; id < iid; id = id + 1) {
+        auto *it = find_rob(id);
+        if (it && it->st_data.has_data()) {
+            Gold_nofity::info("ld iid:{} fwd from st iid:{}", iid, it->rid);
+            ent.ld_data.update_newer(it->st_data);
         }
     }
 
@@ -118,20 +129,20 @@ void Gold_core::st_locally_perform(Inst_id iid) {
     }
     ent.performed = true;
 
-    Rob_queue::reverse_iterator rob_it;
-    rob_it = std::find_if(rob.rbegin(), rob.rend(), [&iid](const Rob_entry &x) { return x.rid == iid; });
-
-    Gold_nofity::trace(iid, "core:{} st lp{}", cid, rob_it->st_data.str());
+    Gold_nofity::trace(iid, "core:{} st lp{}", cid, ent.st_data.str());
 
-    ++rob_it;  // Skip itself
-
-    for (; rob_it != rob.rend(); ++rob_it) {
+    // Younger loads already performed, oldest first
+    for (Inst_id id = iid + 1; id < rob_next; id = id + 1) {
+        auto *rob_it = find_rob(id);
+        if (!rob_it)
+            continue;
         if (!rob_it->ld_data.has_data())
             continue;
         if (!rob_it->performed)
             continue;
 
-        auto ld_data_copy = ld_perform(rob_it->rid);  // perform again
+        auto ld_data_copy = rob_it->ld_data;
+        ld_perform(rob_it->rid);  // perform again
         if (ld_data_copy != rob_it->ld_data) {
             std::cout << "WARNING: ld id:" << rob_it->rid << " performed but data chanced\n";
             rob_it->error = "store id:" + std::to_string(iid) + " changed value";
@@ -148,10 +159,10 @@ void Gold_core::st_locally_merged(Inst_id iid1, Inst_id iid2) {
         iid2     = tmp;
     }
 
-    auto rob_it1 = std::find_if(rob.begin(), rob.end(), [&iid1](const Rob_entry &x) { return x.rid == iid1; });
-    auto rob_it2 = std::find_if(rob.begin(), rob.end(), [&iid2](const Rob_entry &x) { return x.rid == iid2; });
+    auto *rob_it1 = find_rob(iid1);
+    auto *rob_it2 = find_rob(iid2);
 
-    if (rob_it1 == rob.end() || rob_it2 == rob.end()) {
+    if (!rob_it1 || !rob_it2) {
         dump();
         std::cout << "ERROR: locally merge has missign ids iid1:" << iid1 << " iid2:" << iid2 << "\n";
     }
@@ -161,11 +172,11 @@ void Gold_core::st_locally_merged(Inst_id iid1, Inst_id iid2) {
 
     auto &d2 = find_entry(iid2);
 
-    ++rob_it2;  // skip itself
-
-    for (; rob_it2 != rob.end(); ++rob_it2) {
-        if (rob_it2->rid < iid1)
-            return;  // done
+    // Walk from iid2 (skipping itself) down to iid1
+    for (Inst_id id = iid2 - 1; id >= rob_head && id >= iid1; id = id - 1) {
+        rob_it2 = find_rob(id);
+        if (!rob_it2)
+            continue;
 
         if (rob_it2->rid == iid1) {
             assert(rob_it2 == rob_it1);
@@ -190,26 +201,27 @@ void Gold_core::st_locally_merged(Inst_id iid1, Inst_id iid2) {
 }
 
 void Gold_core::st_globally_perform(Inst_id iid) {
-    auto rob_it1 = std::find_if(rob.begin(), rob.end(), [&iid](const Rob_entry &x) { return x.rid == iid; });
+    auto *rob_it1 = find_rob(iid);
 
-    if (rob_it1 == rob.end()) {
+    if (!rob_it1) {
         dump();
         std::cout << "WARNING: globally perform st id:" << iid << " but id is gone. Nothing to do???\n";
         return;
     }
 
-    if (iid < pnr) {
+    if (iid > pnr) {
         dump();
         std::cout << "FAIL: globally perform st id:" << iid << " but NOT safe?? (doing it, but crazy)\n";
     }
 
     // Check that there are no overlapping older stores
 
-    auto it = rob_it1;
-    ++it;  // skip itself
-
     bool only_reads = true;
-    for (; it != rob.end(); ++it) {
+    for (Inst_id id = iid - 1; id >= rob_head; id = id - 1) {  // older, skip itself
+        auto *it = find_rob(id);
+        if (!it)
+            continue;
+
         if (it->st_data.has_data())
             only_reads = false;
 
@@ -230,31 +242,52 @@ void Gold_core::st_globally_perform(Inst_id iid) {
     if (only_reads) {  // try to retire these
         bool notified = false;
 
-        while (rob.back().rid != iid) {
-            auto &oldest = rob.back();
+        for (Inst_id id = rob_head; id < iid; id = id + 1) {
+            auto *oldest = find_rob(id);
+            if (!oldest)
+                continue;
 
-            if (!notified && (!oldest.error.empty() || !oldest.performed)) {
+            if (!notified && (!oldest->error.empty() || !oldest->performed)) {
                 notified = true;
-                std::cout << "FAIL: ld:" << oldest.rid << " is oldest with error:" << oldest.error << "\n";
+                std::cout << "FAIL: ld:" << oldest->rid << " is oldest with error:" << oldest->error << "\n";
                 dump();
             }
 
-            rob.pop_back();
+            oldest->valid = false;
         }
-        assert(rob.back().rid == iid);
-        rob.pop_back();
-    } else {
-        rob.erase(rob_it1);
     }
+    drop(iid);
 
     // Check that itself got deleted
-    assert(std::find_if(rob.begin(), rob.end(), [&iid](const Rob_entry &x) { return x.rid == iid; }) == rob.end());
+    assert(!find_rob(iid));
+}
+
+void Gold_core::ld_retire(Inst_id iid) {
+    auto *e = find_rob(iid);
+
+    if (!e) {
+        dump();
+        std::cout << "WARNING: retire ld id:" << iid << " but id is gone. Nothing to do???\n";
+        return;
+    }
+
+    if (iid > pnr) {
+        dump();
+        std::cout << "FAIL: retire ld id:" << iid << " but NOT safe??\n";
+    }
+
+    if (!e->error.empty() || (e->ld_data.has_data() && !e->performed)) {
+        std::cout << "FAIL: ld:" << iid << " retired with error:" << e->error << "\n";
+        dump();
+    }
+
+    drop(iid);
 }
 
 bool Gold_core::has_error(Inst_id iid) const {
-    auto it = std::find_if(rob.begin(), rob.end(), [&iid](const Rob_entry &x) { return x.rid == iid; });
+    auto *it = find_rob(iid);
 
-    if (it == rob.end())
+    if (!it)
         return true;
 
     return !it->error.empty();
@@ -264,7 +297,8 @@ void Gold_core::dump() const {
     std::cout << "==================================================\n";
     std::cout << "core cid:" << cid << " pnr:" << pnr << "\n";
 
-    for (auto it = rob.rbegin(); it != rob.rend(); ++it) {
-        it->dump("rob");
+    for (Inst_id id = rob_head; id < rob_next; id = id + 1) {
+        if (auto *it = find_rob(id))
+            it->dump("rob");
     }
 }
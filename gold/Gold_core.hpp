@@ -1,13 +1,13 @@
 
 #pragma once
 
-#include <deque>
+#include <vector>
 
 #include "Gold_data.hpp"
 #include "Gold_mem.hpp"
 #include "explicit_type.hpp"
 
-using Inst_id = Explicit_type<int, struct Inst_id_struct, 0>;
+using Inst_id = Explicit_type<int64_t, struct Inst_id_struct, 0>;
 
 enum class Mem_op { Invalid, Load, Store, Ack, Rel, AckRel };
 
@@ -77,6 +77,12 @@ class Gold_core {
      */
     void st_globally_perform(Inst_id iid);
 
+    /** ld_retire
+     * A safe load (or any operation without store data) leaves the
+     * pipeline. Stores leave with st_globally_perform
+     */
+    void ld_retire(Inst_id iid);
+
     bool has_error(Inst_id iid) const;
 
     /** dump
@@ -85,13 +91,27 @@ class Gold_core {
     void dump() const;
 
     /** Constructor
-     *
+     * rob_size is the most instructions in flight, from the oldest not yet
+     * retired to the youngest, rounded up to a power of two
      */
-    explicit Gold_core(Gold_mem &m, int id);
+    explicit Gold_core(Gold_mem &m, int id, size_t rob_size = 1024);
 
   protected:
     struct Rob_entry {
-        Rob_entry(Inst_id i) : rid(i), op(Mem_op::Invalid), performed(false) {}
+        Rob_entry() : rid(0), op(Mem_op::Invalid), performed(false), valid(false) {}
+        Rob_entry(Inst_id i) : rid(i), op(Mem_op::Invalid), performed(false), valid(false) {}
+
+        // Reuse the slot for iid, keeps the buffers already allocated
+        void reset(Inst_id i) {
+            rid = i;
+            ld_data.clear();
+            st_data.clear();
+            op        = Mem_op::Invalid;
+            performed = false;
+            valid     = true;
+            error.clear();
+        }
+
         void dump(const std::string &extra) const {
             std::cout << extra << " rid:" << rid << (performed ? " X" : " W") << " op:" << static_cast<int>(op);
             if (error.empty())
@@ -123,18 +143,33 @@ class Gold_core {
         Gold_data   st_data;
         Mem_op      op;
         bool        performed;
+        bool        valid;
         std::string error;
     };
 
     Rob_entry &find_entry(Inst_id iid);
 
-    Gold_mem &mem;
+    // The slot of iid when it is in flight, null otherwise. O(1)
+    Rob_entry *find_rob(Inst_id iid) {
+        if (iid < rob_head || iid >= rob_next)
+            return nullptr;
+        auto &e = rob[iid & rob_mask];
+        return e.valid && e.rid == iid ? &e : nullptr;
+    }
+    const Rob_entry *find_rob(Inst_id iid) const { return const_cast<Gold_core *>(this)->find_rob(iid); }
 
-    static Inst_id global_instid;
+    // Drop iid, then move the head past the retired slots
+    void drop(Inst_id iid);
 
-    using Rob_queue = std::deque<Rob_entry>;
+    Gold_mem &mem;
 
-    Rob_queue rob;
+    // Instruction state, a ring indexed by Inst_id. Ids are per core and
+    // never reused, [rob_head, rob_next) is in flight, nuked and retired
+    // slots in between are invalid.
+    std::vector<Rob_entry> rob;
+    int64_t                rob_mask;
+    Inst_id                rob_head;
+    Inst_id                rob_next;
 
     Inst_id pnr;
 
@@ -9,7 +9,7 @@ Lrand<uint8_t> Gold_data::Chunk::rand_data;
 std::string Gold_data::str() const {
     std::string msg;
 
-    for (const auto c : chunks) {
+    for (const auto &c : chunks) {
         if (device) {
             msg.append(" DEVICE");
         }
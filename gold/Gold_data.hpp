@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <utility>
@@ -11,6 +13,120 @@
 
 #include "lrand.hpp"
 
+// Bytes of one Gold_data chunk. Up to a cache line (scalar, AMO and most
+// vector accesses) lives inline, only larger chunks go to the heap.
+class Chunk_bytes {
+  public:
+    static constexpr size_t inline_size = 64;
+
+    Chunk_bytes() : ptr(buf), sz(0), cap(inline_size) {}
+    Chunk_bytes(size_t n, uint8_t v) : Chunk_bytes() { resize(n, v); }
+
+    Chunk_bytes(const Chunk_bytes &o) : Chunk_bytes() { assign(o.ptr, o.sz); }
+    Chunk_bytes(Chunk_bytes &&o) noexcept : Chunk_bytes() { take(o); }
+
+    Chunk_bytes &operator=(const Chunk_bytes &o) {
+        if (this != &o)
+            assign(o.ptr, o.sz);
+        return *this;
+    }
+    Chunk_bytes &operator=(Chunk_bytes &&o) noexcept {
+        if (this != &o) {
+            release();
+            take(o);
+        }
+        return *this;
+    }
+
+    ~Chunk_bytes() { release(); }
+
+    size_t         size() const { return sz; }
+    uint8_t       *data() { return ptr; }
+    const uint8_t *data() const { return ptr; }
+    uint8_t       *begin() { return ptr; }
+    uint8_t       *end() { return ptr + sz; }
+    const uint8_t *begin() const { return ptr; }
+    const uint8_t *end() const { return ptr + sz; }
+
+    uint8_t       &operator[](size_t i) { return ptr[i]; }
+    const uint8_t &operator[](size_t i) const { return ptr[i]; }
+
+    void clear() { sz = 0; }
+
+    void resize(size_t n, uint8_t v) {
+        reserve(n);
+        if (n > sz)
+            memset(ptr + sz, v, n - sz);
+        sz = n;
+    }
+
+    void push_back(uint8_t b) {
+        reserve(sz + 1);
+        ptr[sz++] = b;
+    }
+
+    void push_front(uint8_t b) {
+        reserve(sz + 1);
+        memmove(ptr + 1, ptr, sz);
+        ptr[0] = b;
+        ++sz;
+    }
+
+    void append(const Chunk_bytes &o) {
+        reserve(sz + o.sz);
+        memcpy(ptr + sz, o.ptr, o.sz);
+        sz += o.sz;
+    }
+
+    bool operator==(const Chunk_bytes &o) const { return sz == o.sz && memcmp(ptr, o.ptr, sz) == 0; }
+    bool operator!=(const Chunk_bytes &o) const { return !(*this == o); }
+
+  protected:
+    void reserve(size_t n) {
+        if (n <= cap)
+            return;
+        size_t   c = std::max(n, cap * 2);
+        uint8_t *p = static_cast<uint8_t *>(malloc(c));
+        memcpy(p, ptr, sz);
+        release();
+        ptr = p;
+        cap = c;
+    }
+
+    void assign(const uint8_t *p, size_t n) {
+        reserve(n);
+        memcpy(ptr, p, n);
+        sz = n;
+    }
+
+    void take(Chunk_bytes &o) {
+        if (o.ptr == o.buf) {
+            ptr = buf;
+            cap = inline_size;
+            memcpy(buf, o.buf, o.sz);
+        } else {
+            ptr   = o.ptr;
+            cap   = o.cap;
+            o.ptr = o.buf;
+            o.cap = inline_size;
+        }
+        sz   = o.sz;
+        o.sz = 0;
+    }
+
+    void release() {
+        if (ptr != buf)
+            free(ptr);
+        ptr = buf;
+        cap = inline_size;
+    }
+
+    uint8_t *ptr;
+    size_t   sz;
+    size_t   cap;
+    uint8_t  buf[inline_size];
+};
+
 class Gold_data {
   public:
     void clear() {
@@ -20,7 +136,7 @@ class Gold_data {
 
     void set_addr(const uint64_t addr, const uint8_t sz) {
         assert(!has_partial_overlap(addr, sz));  // No overlapping valid ranges
-        chunks.emplace_back(Chunk(addr, sz));
+        chunks.emplace_back(addr, sz);
 
         sort_chunks();
     }
@@ -34,19 +150,17 @@ class Gold_data {
 
             if (c.addr - 1 == addr) {
                 --c.addr;
-                assert(i > 0 && !chunks[i - 1].is_hit(addr - 1));
-                c.data.insert(c.data.begin(), 1, rand_data.any());
+                assert(i == 0 || !chunks[i - 1].is_hit(addr - 1));
+                c.data.push_front(rand_data.any());
                 return;
             }
 
             if ((c.addr + c.data.size()) == addr) {
-                c.data.emplace_back(rand_data.any());
+                c.data.push_back(rand_data.any());
 
-                if (chunks.size() < i && chunks[i + 1].addr == addr) {  // merge with
-                                                                        // next
-                    c.data.insert(c.data.end(), chunks[i + 1].data.begin(), chunks[i + 1].data.end());
-                    ++i;
-                    chunks.erase(chunks.begin() + i);
+                if (i + 1 < chunks.size() && chunks[i + 1].addr == addr + 1) {  // merge with next
+                    c.data.append(chunks[i + 1].data);
+                    chunks.erase(chunks.begin() + i + 1);
                 }
                 return;
             }
@@ -56,6 +170,11 @@ class Gold_data {
     }
 
     void add_addr(const uint64_t addr, const uint8_t sz) {
+        if (chunks.empty()) {  // common case, one access into a clear Gold_data
+            set_addr(addr, sz);
+            return;
+        }
+
         for (auto i = 0u; i < sz; ++i) {
             add_addr(addr + i);
         }
@@ -63,6 +182,13 @@ class Gold_data {
 
     void set_data(const uint64_t addr, const uint8_t sz, uint64_t d) {
         assert(sz <= 8);
+        if (Chunk *c = find_chunk(addr, sz)) {
+            for (int i = 0; i < sz; ++i) {
+                c->data[addr - c->addr + i] = d & 0xFF;
+                d                           = d >> 8;
+            }
+            return;
+        }
         for (int i = 0; i < sz; ++i) {
             set_byte(addr + i, d & 0xFF);
             d = d >> 8;
@@ -72,6 +198,12 @@ class Gold_data {
     uint64_t get_data(const uint64_t addr, const uint8_t sz) const {
         uint64_t d = 0;
         assert(sz <= 8);
+        if (const Chunk *c = find_chunk(addr, sz)) {
+            for (int i = 0; i < sz; ++i) {
+                d = (d << 8) | c->data[addr - c->addr + sz - i - 1];
+            }
+            return d;
+        }
         for (int i = 0; i < sz; ++i) {
             uint64_t b = get_byte(addr + sz - i - 1);
             d          = (d << 8) | b;
@@ -80,16 +212,7 @@ class Gold_data {
         return d;
     }
 
-    bool has_full_overlap(const uint64_t addr, const uint8_t sz) const {
-        for (const auto &c : chunks) {
-            if (c.addr <= addr && addr + sz <= c.addr + c.data.size()) {
-                //     [c;              c+size]
-                //          [addr; addr+sz]
-                return true;
-            }
-        }
-        return false;
-    }
+    bool has_full_overlap(const uint64_t addr, const uint8_t sz) const { return find_chunk(addr, sz) != nullptr; }
 
     bool has_partial_overlap(const uint64_t addr, const uint8_t sz) const {
         for (const auto &c : chunks) {
@@ -145,7 +268,7 @@ class Gold_data {
     void dump() const { std::cout << str(); }
 
     void add_newer(const Gold_data &d2) {
-        for (const auto c : d2.chunks) {
+        for (const auto &c : d2.chunks) {
             add_addr(c.addr, c.data.size());
             for (auto i = 0u; i < c.data.size(); ++i) {
                 set_byte(c.addr + i, c.data[i]);
@@ -154,7 +277,7 @@ class Gold_data {
     }
 
     void update_newer(const Gold_data &d2) {
-        for (const auto c : d2.chunks) {
+        for (const auto &c : d2.chunks) {
             if (!has_partial_overlap(c.addr, c.data.size()))
                 continue;
 
@@ -169,15 +292,18 @@ class Gold_data {
 
     void set_device() { device = true; }
 
-    void each_chunk(std::function<void(uint64_t, const std::vector<uint8_t> &)> fun) {
-        for (const auto c : chunks) {
-            fun(c.addr, c.data);
+    // fun(addr, data, size) for each chunk, the data can be filled in place
+    template <class Fun>
+    void each_chunk(Fun fun) {
+        for (auto &c : chunks) {
+            fun(c.addr, c.data.data(), c.data.size());
         }
     }
 
-    void each_chunk(std::function<void(uint64_t, const std::vector<uint8_t> &)> fun) const {
-        for (const auto c : chunks) {
-            fun(c.addr, c.data);
+    template <class Fun>
+    void each_chunk(Fun fun) const {
+        for (const auto &c : chunks) {
+            fun(c.addr, static_cast<const uint8_t *>(c.data.data()), c.data.size());
         }
     }
 
@@ -191,15 +317,12 @@ class Gold_data {
 
         for (; it1 != chunks.end() && it2 != d2.chunks.end(); ++it1, ++it2) {
             if (it1->addr != it2->addr)
-                return false;
+                return true;
             if (it1->data != it2->data)
-                return false;
-        }
-        if ((it1 == chunks.end() && it2 != d2.chunks.end()) || (it1 != chunks.end() && it2 == d2.chunks.end())) {
-            return false;
+                return true;
         }
 
-        return true;
+        return it1 != chunks.end() || it2 != d2.chunks.end();
     }
 
     Gold_data() { device = false; }
@@ -207,8 +330,12 @@ class Gold_data {
   protected:
     static Lrand<uint8_t> rand_data;
 
+    // The new chunk is at the back, only sort when it is out of order
     void sort_chunks() {
-        std::sort(chunks.begin(), chunks.end(), [](const Chunk &a, const Chunk &b) -> bool { return a.addr < b.addr; });
+        auto n = chunks.size();
+        if (n > 1 && chunks[n - 2].addr > chunks[n - 1].addr) {
+            std::sort(chunks.begin(), chunks.end(), [](const Chunk &a, const Chunk &b) -> bool { return a.addr < b.addr; });
+        }
 #ifndef NDEBUG
         for (auto i = 1u; i < chunks.size(); ++i) {
             assert(chunks[i - 1].addr + chunks[i - 1].data.size() < chunks[i].addr);  // no overlap, no even concatenatable chunks
@@ -223,7 +350,7 @@ class Gold_data {
             data.clear();
         }
 
-        Chunk(uint64_t a, uint8_t s) : addr(a) { data.resize(s, rand_data.any()); }
+        Chunk(uint64_t a, uint8_t s) : addr(a), data(s, rand_data.any()) {}
 
         bool is_hit(uint64_t a) const { return addr <= a && (addr + data.size()) > a; }
 
@@ -241,10 +368,26 @@ class Gold_data {
             return data[a - addr];
         }
 
-        uint64_t             addr;
-        std::vector<uint8_t> data;
+        uint64_t    addr;
+        Chunk_bytes data;
     };
 
+    // The chunk holding all of [addr, addr+sz), or null
+    Chunk *find_chunk(const uint64_t addr, const uint8_t sz) {
+        return const_cast<Chunk *>(static_cast<const Gold_data *>(this)->find_chunk(addr, sz));
+    }
+
+    const Chunk *find_chunk(const uint64_t addr, const uint8_t sz) const {
+        for (const auto &c : chunks) {
+            if (c.addr <= addr && addr + sz <= c.addr + c.data.size()) {
+                //     [c;              c+size]
+                //          [addr; addr+sz]
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
     std::vector<Chunk> chunks;
     bool               device;
 };
@@ -1,8 +1,12 @@
 #pragma once
 
-// TODO: the mem is byte (not efficient maybe line base?)
+// Memory is a sparse table of 4 KiB byte pages. A presence bit per byte
+// says whether the byte was stored or already fetched from the backing
+// memory, the rest are fetched with get_byte on the first load.
 
 #include <algorithm>
+#include <cstring>
+#include <memory>
 
 #include "Gold_data.hpp"
 #include "robin_hood.hpp"
@@ -12,32 +16,144 @@ class Gold_mem {
     Gold_mem(std::function<uint8_t(uint64_t)> gb) : get_byte(gb) {}
 
     void st_perform(const Gold_data &st_data) {
-        st_data.each_chunk([this](uint64_t addr, const std::vector<uint8_t> &data) {
-            for (auto b_pos = 0u; b_pos < data.size(); ++b_pos) {
-                mem_byte[addr + b_pos] = data[b_pos];
-            }
-        });
+        st_data.each_chunk([this](uint64_t addr, const uint8_t *data, size_t sz) { st_bytes(addr, data, sz); });
     }
 
     void ld_perform(Gold_data &ld_data) {
-        ld_data.each_chunk([this, &ld_data](uint64_t addr, const std::vector<uint8_t> &data) {
-            for (auto b_pos = 0u; b_pos < data.size(); ++b_pos) {
-                auto a = addr + b_pos;
-
-                auto it = mem_byte.find(a);
-                if (it == mem_byte.end()) {
-                    auto b      = get_byte(a);
-                    mem_byte[a] = b;
-                    ld_data.set_byte(a, b);
-                } else {
-                    ld_data.set_byte(a, it->second);
+        ld_data.each_chunk([this](uint64_t addr, uint8_t *data, size_t sz) { ld_bytes(addr, data, sz); });
+    }
+
+    void st_bytes(uint64_t addr, const uint8_t *data, size_t sz) {
+        if (is_aligned_word(addr, sz)) {
+            Page  *p   = find_page(addr, true);
+            size_t off = addr & page_mask;
+            copy_word(p->byte + off, data, sz);
+            p->present[off >> 6] |= word_mask(off, sz);
+            return;
+        }
+
+        while (sz) {
+            Page  *p   = find_page(addr, true);
+            size_t off = addr & page_mask;
+            size_t n   = std::min(sz, page_size - off);
+
+            memcpy(p->byte + off, data, n);
+            set_present(p, off, n);
+
+            addr += n;
+            data += n;
+            sz -= n;
+        }
+    }
+
+    void ld_bytes(uint64_t addr, uint8_t *data, size_t sz) {
+        if (is_aligned_word(addr, sz)) {
+            Page    *p    = find_page(addr, true);
+            size_t   off  = addr & page_mask;
+            uint64_t mask = word_mask(off, sz);
+            if ((p->present[off >> 6] & mask) == mask) {
+                copy_word(data, p->byte + off, sz);
+                return;
+            }
+        }
+
+        while (sz) {
+            Page  *p   = find_page(addr, true);
+            size_t off = addr & page_mask;
+            size_t n   = std::min(sz, page_size - off);
+
+            if (!all_present(p, off, n)) {
+                for (size_t i = 0; i < n; ++i) {
+                    if (!is_present(p, off + i))
+                        p->byte[off + i] = get_byte(addr + i);
                 }
+                set_present(p, off, n);
             }
-        });
+            memcpy(data, p->byte + off, n);
+
+            addr += n;
+            data += n;
+            sz -= n;
+        }
     }
 
   protected:
+    static constexpr int      page_bits = 12;
+    static constexpr size_t   page_size = size_t(1) << page_bits;
+    static constexpr uint64_t page_mask = page_size - 1;
+
+    struct Page {
+        uint64_t present[page_size / 64];
+        uint8_t  byte[page_size];
+    };
+
+    Page *find_page(uint64_t addr, bool alloc) {
+        uint64_t pn = addr >> page_bits;
+        if (last_page && pn == last_pn)
+            return last_page;
+
+        auto it = pages.find(pn);
+        if (it == pages.end()) {
+            if (!alloc)
+                return nullptr;
+            auto p = std::make_unique<Page>();
+            it = pages.emplace(pn, std::move(p)).first;
+        }
+
+        last_pn   = pn;
+        last_page = it->second.get();
+        return last_page;
+    }
+
+    // Aligned 1, 2, 4 and 8 byte accesses stay in one page and one bitmap
+    // word
+    static bool is_aligned_word(uint64_t addr, size_t sz) {
+        return sz && sz <= 8 && (sz & (sz - 1)) == 0 && (addr & (sz - 1)) == 0;
+    }
+
+    static uint64_t word_mask(size_t off, size_t sz) { return ((uint64_t(1) << sz) - 1) << (off & 63); }
+
+    static void copy_word(uint8_t *dst, const uint8_t *src, size_t sz) {
+        switch (sz) {
+            case 1: *dst = *src; break;
+            case 2: memcpy(dst, src, 2); break;
+            case 4: memcpy(dst, src, 4); break;
+            default: memcpy(dst, src, 8); break;
+        }
+    }
+
+    // Presence bits of [off, off+n), n > 0, split per bitmap word
+    template <class Fun>
+    static bool each_present_word(size_t off, size_t n, Fun fun) {
+        while (n) {
+            size_t   bit  = off & 63;
+            size_t   len  = std::min(n, 64 - bit);
+            uint64_t mask = len == 64 ? ~uint64_t(0) : ((uint64_t(1) << len) - 1) << bit;
+            if (!fun(off >> 6, mask))
+                return false;
+            off += len;
+            n -= len;
+        }
+        return true;
+    }
+
+    static bool is_present(const Page *p, size_t off) { return (p->present[off >> 6] >> (off & 63)) & 1; }
+
+    static bool all_present(const Page *p, size_t off, size_t n) {
+        return each_present_word(off, n, [p](size_t w, uint64_t mask) { return (p->present[w] & mask) == mask; });
+    }
+
+    static void set_present(Page *p, size_t off, size_t n) {
+        each_present_word(off, n, [p](size_t w, uint64_t mask) {
+            p->present[w] |= mask;
+            return true;
+        });
+    }
+
     std::function<uint8_t(uint64_t)> get_byte;
 
-    robin_hood::unordered_map<uint64_t, uint8_t> mem_byte;
+    robin_hood::unordered_map<uint64_t, std::unique_ptr<Page>> pages;
+
+    uint64_t last_pn   = 0;
+    Page    *last_page = nullptr;
 };
@@ -40,6 +40,9 @@ void check_inorder_load(int cid, uint64_t addr, uint8_t sz, uint64_t rd_data, bo
         cores[cid].dump();
         exit(-3);
     }
+
+    cores[cid].set_safe(rid);
+    cores[cid].ld_retire(rid);
 }
 
 void check_inorder_store(int cid, uint64_t addr, uint8_t sz, uint64_t st_data, bool io_map) {
@@ -52,6 +55,7 @@ void check_inorder_store(int cid, uint64_t addr, uint8_t sz, uint64_t st_data, b
     if (io_map)
         d.set_device();
 
+    cores[cid].set_safe(rid);
     cores[cid].st_globally_perform(rid);
 }
 
@@ -87,5 +91,6 @@ void check_inorder_amo(int cid, uint64_t addr, uint8_t sz, uint64_t st_data, uin
         exit(-3);
     }
 
+    cores[cid].set_safe(rid);
     cores[cid].st_globally_perform(rid);
 }
@@ -0,0 +1,64 @@
+
+#include <vector>
+
+#include "Gold_core.hpp"
+#include "Gold_notify.hpp"
+#include "bridge_ooo.h"
+
+/* Entry points for an out-of-order DUT. The DUT reports each memory
+ * operation as it goes through its pipeline, see doc/goldmem.md.
+ */
+
+extern uint8_t majordomo_get_byte_direct(uint64_t paddr);
+
+static Gold_mem               mem(majordomo_get_byte_direct);
+static std::vector<Gold_core> cores;
+
+void majordomo_gold_init(int ncores, int rob_size) {
+    cores.clear();
+    cores.reserve(ncores);
+    for (int i = 0; i < ncores; ++i) {
+        cores.emplace_back(mem, i, rob_size > 0 ? rob_size : 1024);
+    }
+}
+
+int64_t majordomo_gold_inorder(int cid) { return cores[cid].inorder(); }
+
+void majordomo_gold_set_type(int cid, int64_t iid, int op) {
+    assert(op >= MAJORDOMO_GOLD_LOAD && op <= MAJORDOMO_GOLD_ACKREL);
+    cores[cid].set_type(iid, static_cast<Mem_op>(op));
+}
+
+void majordomo_gold_set_safe(int cid, int64_t iid) { cores[cid].set_safe(iid); }
+
+void majordomo_gold_nuke(int cid, int64_t iid) { cores[cid].nuke(iid); }
+
+uint64_t majordomo_gold_ld_perform(int cid, int64_t iid, uint64_t addr, uint8_t sz, bool io_map) {
+    auto &d = cores[cid].ld_data_ref(iid);
+    if (!d.has_full_overlap(addr, sz))
+        d.add_addr(addr, sz);
+    if (io_map)
+        d.set_device();
+
+    cores[cid].ld_perform(iid);
+
+    return d.get_data(addr, sz);
+}
+
+void majordomo_gold_st_data(int cid, int64_t iid, uint64_t addr, uint8_t sz, uint64_t data, bool io_map) {
+    auto &d = cores[cid].st_data_ref(iid);
+    d.add_addr(addr, sz);
+    d.set_data(addr, sz, data);
+    if (io_map)
+        d.set_device();
+}
+
+void majordomo_gold_st_locally_perform(int cid, int64_t iid) { cores[cid].st_locally_perform(iid); }
+
+void majordomo_gold_st_locally_merged(int cid, int64_t iid1, int64_t iid2) { cores[cid].st_locally_merged(iid1, iid2); }
+
+void majordomo_gold_st_globally_perform(int cid, int64_t iid) { cores[cid].st_globally_perform(iid); }
+
+void majordomo_gold_ld_retire(int cid, int64_t iid) { cores[cid].ld_retire(iid); }
+
+bool majordomo_gold_has_error(int cid, int64_t iid) { return cores[cid].has_error(iid); }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Goldmem bridge for an out-of-order DUT (gold/bridge_ooo.cpp)
+ *
+ * Each memory operation gets an id from majordomo_gold_inorder() in
+ * program order, then the DUT reports its type, when a load binds its
+ * value, when a store's data is known and when it is globally visible,
+ * and when operations become non-speculative or are flushed.  Ids are
+ * per core.  Up to rob_size operations per core may be in flight, from
+ * the oldest not yet retired to the youngest.  See doc/goldmem.md.
+ * Included by majordomo_cosim.h in GOLDMEM builds.
+ */
+enum {
+    MAJORDOMO_GOLD_LOAD = 1,
+    MAJORDOMO_GOLD_STORE,
+    MAJORDOMO_GOLD_ACK,
+    MAJORDOMO_GOLD_REL,
+    MAJORDOMO_GOLD_ACKREL,
+};
+
+/* Creates the cores, rob_size <= 0 is the default of 1024 */
+void majordomo_gold_init(int ncores, int rob_size);
+
+/* Id of the next memory operation in program order */
+int64_t majordomo_gold_inorder(int cid);
+
+/* MAJORDOMO_GOLD_*, before set_safe.  Ignored for a flushed id */
+void majordomo_gold_set_type(int cid, int64_t iid, int op);
+
+/* iid and everything older can no longer be flushed */
+void majordomo_gold_set_safe(int cid, int64_t iid);
+
+/* Flushes iid and everything younger, ids are not handed out again */
+void majordomo_gold_nuke(int cid, int64_t iid);
+
+/* Binds the load value, forwarding from older stores in flight, and
+ * returns the gold data.  Call again to replay the load. */
+uint64_t majordomo_gold_ld_perform(int cid, int64_t iid, uint64_t addr, uint8_t sz, bool io_map);
+
+/* Address and data of a store (or the store part of an AMO) */
+void majordomo_gold_st_data(int cid, int64_t iid, uint64_t addr, uint8_t sz, uint64_t data, bool io_map);
+
+/* The store data is visible to younger loads of this core.  Younger
+ * loads already performed with other data get an error */
+void majordomo_gold_st_locally_perform(int cid, int64_t iid);
+
+/* Merges store iid2 into iid1, both locally performed and safe */
+void majordomo_gold_st_locally_merged(int cid, int64_t iid1, int64_t iid2);
+
+/* The store is visible to all cores, retires it */
+void majordomo_gold_st_globally_perform(int cid, int64_t iid);
+
+/* A safe load, or any operation without store data, leaves the pipeline */
+void majordomo_gold_ld_retire(int cid, int64_t iid);
+
+/* True when iid was flushed or a younger check failed on it */
+bool majordomo_gold_has_error(int cid, int64_t iid);
+
+#ifdef __cplusplus
+}  // extern C
+#endif
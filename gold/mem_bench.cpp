@@ -0,0 +1,96 @@
+
+// Gold_mem load/store benchmark against the previous byte map memory.
+//
+//   g++ -std=c++20 -O2 -I. -I../external -o mem_bench mem_bench.cpp Gold_data.cpp
+//       lrand.cpp ../external/fmt/format.cc ../external/fmt/os.cc
+
+#include <chrono>
+#include <cstdio>
+
+#include "Gold_mem.hpp"
+
+uint8_t get_byte(uint64_t addr) { return addr >> 4; }
+
+// The Gold_mem before the page table, one hash entry per byte
+class Gold_mem_byte_map {
+  public:
+    Gold_mem_byte_map(std::function<uint8_t(uint64_t)> gb) : get_byte(gb) {}
+
+    void st_perform(const Gold_data &st_data) {
+        st_data.each_chunk([this](uint64_t addr, const uint8_t *data, size_t sz) {
+            for (auto b_pos = 0u; b_pos < sz; ++b_pos) {
+                mem_byte[addr + b_pos] = data[b_pos];
+            }
+        });
+    }
+
+    void ld_perform(Gold_data &ld_data) {
+        ld_data.each_chunk([this, &ld_data](uint64_t addr, uint8_t *data, size_t sz) {
+            for (auto b_pos = 0u; b_pos < sz; ++b_pos) {
+                auto a = addr + b_pos;
+
+                auto it = mem_byte.find(a);
+                if (it == mem_byte.end()) {
+                    auto b      = get_byte(a);
+                    mem_byte[a] = b;
+                    ld_data.set_byte(a, b);
+                } else {
+                    ld_data.set_byte(a, it->second);
+                }
+            }
+        });
+    }
+
+  protected:
+    std::function<uint8_t(uint64_t)> get_byte;
+
+    robin_hood::unordered_map<uint64_t, uint8_t> mem_byte;
+};
+
+// 1, 2, 4 and 8 byte accesses over a 16 MiB footprint, one in eight
+// unaligned, one in four a store. Returns a checksum of the loaded data.
+template <class Mem>
+static uint64_t run(Mem &mem, int n_ops, double &secs) {
+    Lrand<uint64_t> rnd(42);
+    Gold_data       d;
+    uint64_t        sum = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_ops; ++i) {
+        uint64_t r    = rnd.any();
+        uint8_t  sz   = uint8_t(1) << (r & 3);
+        uint64_t addr = 0x80000000 + ((r >> 8) & 0xFFFFFF);
+        if ((r >> 4) & 7)
+            addr &= ~uint64_t(sz - 1);
+
+        d.clear();
+        d.set_addr(addr, sz);
+        if (((r >> 32) & 3) == 0) {
+            d.set_data(addr, sz, r);
+            mem.st_perform(d);
+        } else {
+            mem.ld_perform(d);
+            sum += d.get_data(addr, sz);
+        }
+    }
+    secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    return sum;
+}
+
+int main() {
+    const int n_ops = 4000000;
+
+    Gold_mem_byte_map old_mem(get_byte);
+    Gold_mem          new_mem(get_byte);
+
+    double   old_secs, new_secs;
+    uint64_t old_sum = run(old_mem, n_ops, old_secs);
+    uint64_t new_sum = run(new_mem, n_ops, new_secs);
+
+    printf("byte map   %.3fs %.2f Mops/s\n", old_secs, 1e-6 * n_ops / old_secs);
+    printf("page table %.3fs %.2f Mops/s\n", new_secs, 1e-6 * n_ops / new_secs);
+    printf("speedup    %.2fx\n", old_secs / new_secs);
+
+    assert(old_sum == new_sum);
+}
@@ -0,0 +1,66 @@
+
+#include <cstdio>
+
+#include "bridge_ooo.h"
+
+uint8_t majordomo_get_byte_direct(uint64_t addr) { return addr >> 4; }
+
+static int failures = 0;
+
+// Not assert, so the checks also run in NDEBUG builds
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: FAIL %s\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                 \
+        }                                                               \
+    } while (0)
+
+int main() {
+    majordomo_gold_init(1, 8);
+
+    // A store and a younger load to the same address, the load runs first
+    auto st = majordomo_gold_inorder(0);
+    majordomo_gold_set_type(0, st, MAJORDOMO_GOLD_STORE);
+    auto ld = majordomo_gold_inorder(0);
+    majordomo_gold_set_type(0, ld, MAJORDOMO_GOLD_LOAD);
+
+    CHECK(majordomo_gold_ld_perform(0, ld, 0x200, 2, false) == 0x2020);
+
+    majordomo_gold_st_data(0, st, 0x200, 2, 0xbeef, false);
+    majordomo_gold_st_locally_perform(0, st);
+    CHECK(majordomo_gold_has_error(0, ld));  // stale load
+
+    // Flush the load and replay it, it forwards from the store
+    majordomo_gold_nuke(0, ld);
+    CHECK(majordomo_gold_has_error(0, ld));
+    ld = majordomo_gold_inorder(0);
+    majordomo_gold_set_type(0, ld, MAJORDOMO_GOLD_LOAD);
+    CHECK(majordomo_gold_ld_perform(0, ld, 0x200, 2, false) == 0xbeef);
+    CHECK(!majordomo_gold_has_error(0, ld));
+
+    majordomo_gold_set_safe(0, ld);
+    majordomo_gold_st_globally_perform(0, st);
+    majordomo_gold_ld_retire(0, ld);
+
+    // Many more ops than the ring over time, retiring in order
+    for (int i = 0; i < 1000; ++i) {
+        auto s = majordomo_gold_inorder(0);
+        majordomo_gold_set_type(0, s, MAJORDOMO_GOLD_STORE);
+        majordomo_gold_st_data(0, s, 0x1000 + 8 * (i % 4), 8, i, false);
+        majordomo_gold_set_safe(0, s);
+        majordomo_gold_st_globally_perform(0, s);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        auto l = majordomo_gold_inorder(0);
+        majordomo_gold_set_type(0, l, MAJORDOMO_GOLD_LOAD);
+        CHECK(majordomo_gold_ld_perform(0, l, 0x1000 + 8 * (999 % 4), 8, false) == 999);
+        majordomo_gold_set_safe(0, l);
+        majordomo_gold_ld_retire(0, l);
+    }
+
+    if (failures)
+        return 1;
+    printf("gold ooo bridge checks pass\n");
+    return 0;
+}
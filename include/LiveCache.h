@@ -61,64 +61,225 @@
 #include <unistd.h>
 
 #include <string>
+#include <vector>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "majordomo_warmup.h"
+
+// One level of the hierarchy, as described by the live cache config
+enum LiveCacheSide { LC_UNIFIED, LC_INST, LC_DATA };
+
+// Relation of a level to the levels above it (closer to the core)
+//   inclusive - holds every line of the levels above, evicting a line
+//               back-invalidates it above
+//   exclusive - holds only lines evicted from the level above, a hit
+//               moves the line up
+//   nine      - non-inclusive non-exclusive, filled on a miss but never
+//               back-invalidates
+enum LiveCacheInclusion { LC_INCLUSIVE, LC_EXCLUSIVE, LC_NINE };
+
+struct LiveCacheLevelConfig {
+    std::string        name;
+    uint64_t           size      = 0;
+    int32_t            assoc     = 16;
+    int32_t            line_size = 64;
+    std::string        policy    = "LRU";  // LRU, LRUp or RANDOM
+    LiveCacheSide      side      = LC_UNIFIED;
+    LiveCacheInclusion inclusion = LC_INCLUSIVE;
+};
+
+// -------------------------------------------------------------------------
+// One level. Sets are laid out back to back, each one holding its tags,
+// then its LRU stamps, then a bit mask of the ways holding stored lines,
+// padded to a host cache line:
+//
+//   uint32_t tag[assoc]     line index from mem_base + 1, 0 is empty
+//   uint64_t stamp[assoc]   recency, larger is more recent
+//   uint64_t stores
+//
+// The tag compare runs across all ways of a set with SSE2/AVX2 when the
+// host has it. Stamps come from one counter per level, so they also give
+// the recency order of the whole level for traverse().
+// -------------------------------------------------------------------------
 class LiveCache {
   protected:
-    class CState : public StateGeneric<uint64_t> {
-      private:
-        enum StateType { M, E, S, I };
-        StateType state;
+    const LiveCacheLevelConfig cfg;
+
+    const uint64_t mem_base;
+
+    ReplacementPolicy policy;
+
+    uint32_t assoc;
+    uint32_t numSets;
+    uint32_t setMask;
+    uint32_t lineSizeBits;
+    uint32_t setBytes;
+    uint64_t stampOffset;
+    uint64_t storesOffset;
+    uint8_t *sets;
 
-      public:
-        bool     st;
+    uint64_t maxOrder;
+    uint64_t lastIdx;  // line index of the last access, it holds maxOrder
+    uint64_t rnd;
+
+    long long nReadHit;
+    long long nReadMiss;
+    long long nWriteHit;
+    long long nWriteMiss;
+
+    struct Entry {
         uint64_t order;
+        uint64_t addr;
+    };
+    static void radixSort(std::vector<Entry> &arr, uint64_t minOrder);
+
+    uint32_t *tagsOf(uint32_t set) const { return (uint32_t *)(sets + (uint64_t)set * setBytes); }
+    uint64_t *stampsOf(uint32_t set) const { return (uint64_t *)(sets + (uint64_t)set * setBytes + stampOffset); }
+    uint64_t &storesOf(uint32_t set) const { return *(uint64_t *)(sets + (uint64_t)set * setBytes + storesOffset); }
 
-        CState() {
-            state = I;
-            clearTag();
+    uint64_t lineIdx(uint64_t addr) const { return (addr - mem_base) >> lineSizeBits; }
+    uint64_t lineAddr(uint32_t tag) const { return mem_base + ((uint64_t)(tag - 1) << lineSizeBits); }
+
+    static inline int findWay(const uint32_t *tags, uint32_t tag, uint32_t assoc) {
+#if defined(__AVX2__)
+        if ((assoc & 7) == 0) {
+            __m256i key = _mm256_set1_epi32((int)tag);
+            for (uint32_t i = 0; i < assoc; i += 8) {
+                __m256i t = _mm256_load_si256((const __m256i *)(tags + i));
+                int     m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(t, key)));
+                if (m)
+                    return i + __builtin_ctz(m);
+            }
+            return -1;
+        }
+#endif
+#if defined(__SSE2__)
+        if ((assoc & 3) == 0) {
+            __m128i key = _mm_set1_epi32((int)tag);
+            for (uint32_t i = 0; i < assoc; i += 4) {
+                __m128i t = _mm_load_si128((const __m128i *)(tags + i));
+                int     m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(t, key)));
+                if (m)
+                    return i + __builtin_ctz(m);
+            }
+            return -1;
         }
+#endif
+        for (uint32_t i = 0; i < assoc; i++)
+            if (tags[i] == tag)
+                return i;
+        return -1;
+    }
+
+  public:
+    LiveCache(const LiveCacheLevelConfig &_cfg, uint64_t mem_base);
+    virtual ~LiveCache();
 
-        bool isModified() const { return state == M; }
-        void setModified() { state = M; }
-        bool isValid() const { return state != I; }
-        bool isInvalid() const { return state == I; }
+    const LiveCacheLevelConfig &getConfig() const { return cfg; }
+    const std::string &         getName() const { return cfg.name; }
+    int32_t                     getLineSize() const { return 1 << lineSizeBits; }
 
-        StateType getState() const { return state; };
+    // Lookup, a hit refreshes the line and merges the store bit
+    bool access(uint64_t addr, bool st) {
+        uint64_t idx = lineIdx(addr);
 
-        void invalidate() { state = I; }
-    };
+        // Same line as the last access, it already has the newest stamp
+        if (idx == lastIdx && !st) {
+            nReadHit++;
+            return true;
+        }
 
-    typedef CacheGeneric<CState, uint64_t>            CacheType;
-    typedef CacheGeneric<CState, uint64_t>::CacheLine Line;
+        uint32_t set = idx & setMask;
+        int      way = findWay(tagsOf(set), (uint32_t)idx + 1, assoc);
+        if (way < 0) {
+            if (st)
+                nWriteMiss++;
+            else
+                nReadMiss++;
+            return false;
+        }
 
-    const std::string name;
+        stampsOf(set)[way] = ++maxOrder;
+        lastIdx            = idx;
+        if (st) {
+            storesOf(set) |= 1ULL << way;
+            nWriteHit++;
+        } else {
+            nReadHit++;
+        }
+        return true;
+    }
 
-    CacheType *cacheBank;
+    // Allocate addr, returns true and the victim when a resident line
+    // was evicted
+    bool fill(uint64_t addr, bool st, uint64_t &victim, bool &victim_st);
+    // Drop addr, returns true and its store bit when it was resident
+    bool invalidate(uint64_t addr, bool &was_st);
+    // Set the store bit of a resident line without touching recency,
+    // returns false when addr is not resident
+    bool markStore(uint64_t addr);
 
-    int32_t  lineSize;
-    int32_t  lineSizeBits;
-    uint64_t lineCount;
-    uint64_t maxOrder;
+    // Resident lines, least recently used first, bit 0 set for stores.
+    // Linear in the number of resident lines.
+    void traverse(std::vector<uint64_t> &lines) const;
+};
+
+// -------------------------------------------------------------------------
+// The tracked hierarchy. Levels are listed core side first, instruction
+// fetches walk the unified and inst levels, loads and stores the unified
+// and data levels. Only accesses to [mem_base, mem_base+mem_size) are
+// tracked.
+// -------------------------------------------------------------------------
+class LiveCacheHierarchy {
+  protected:
+    std::vector<LiveCache *> levels;
+    std::vector<int>         ipath;
+    std::vector<int>         dpath;
 
     uint64_t mem_base;
     uint64_t mem_end;
 
-    long long nReadHit;
-    long long nReadMiss;
-    long long nWriteHit;
-    long long nWriteMiss;
+    // Misses in the first level of path
+    void miss(const std::vector<int> &path, uint64_t addr, bool st);
+    void insert(const std::vector<int> &path, size_t pos, uint64_t addr, bool st);
+
+    void access(const std::vector<int> &path, uint64_t addr, bool st) {
+        if (addr - mem_base >= mem_end - mem_base)
+            return;  // only track between mem_base and mem_end
 
-    void mergeSort(Line **arr, uint64_t len);
+        if (!levels[path[0]]->access(addr, st))
+            miss(path, addr, st);
+    }
 
   public:
-    LiveCache(const std::string &_name, int size, uint64_t mem_base, uint64_t mem_size);
-    virtual ~LiveCache();
+    LiveCacheHierarchy(const std::vector<LiveCacheLevelConfig> &cfgs, uint64_t mem_base, uint64_t mem_size);
+    virtual ~LiveCacheHierarchy();
+
+    void iread(uint64_t addr) { access(ipath, addr, false); }
+    void read(uint64_t addr) { access(dpath, addr, false); }
+    void write(uint64_t addr) { access(dpath, addr, true); }
+
+    int        getNumLevels() const { return (int)levels.size(); }
+    LiveCache *getLevel(int i) const { return levels[i]; }
 
-    int32_t getLineSize() const { return lineSize; }
+    // Resident set of every level
+    void exportWarmup(std::vector<WarmupLevel> &warm) const;
+    // Fill each level from the warm set level of the same name, without
+    // hierarchy side effects
+    void preload(const std::vector<WarmupLevel> &warm);
 
-    void      read(uint64_t addr);
-    void      write(uint64_t addr);
-    uint64_t *traverse(uint64_t &n_entries);
+    // Write the resident sets to <dump_name>.warmup
+    bool dump(const char *dump_name) const;
 };
 
+// Default hierarchy, one 16 way LRU level of the given size
+std::vector<LiveCacheLevelConfig> livecache_default_config(uint64_t size);
+
+// Read a hierarchy description, {"levels": [ {...}, ... ]}, from a JSON
+// file. Returns false and reports the problem on a malformed config.
+bool livecache_load_config(const char *filename, std::vector<LiveCacheLevelConfig> &cfgs);
+
 #endif
@@ -0,0 +1,170 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Zbb orc.b/rev8 and Zbc clmul/clmulh/clmulr on host instructions.
+ *
+ * The ref_ versions are the portable definitions, one bit or byte at a
+ * time, and the host_ versions are checked against them by
+ * md_bitmanip_bench. For 32 and 64 bit operands:
+ *   orc.b   SSE2 byte compare against zero, a SWAR add/or on other hosts
+ *   rev8    __builtin_bswap, a single bswap/rev instruction
+ *   clmul*  PCLMULQDQ when the build targets it or CPUID has it at run
+ *           time, the reference loop otherwise
+ * Wider operands (XLEN=128) use the reference versions.
+ */
+#ifndef BITMANIP_HOST_H
+#define BITMANIP_HOST_H
+
+#include <stdint.h>
+
+#include <array>
+#include <bit>
+
+#if defined(__SSE2__) && defined(__x86_64__)
+#define BITMANIP_HOST_X86
+#include <immintrin.h>
+#endif
+
+template <class U>
+static inline U ref_orc_b(U rs) {
+    auto bytes = std::bit_cast<std::array<uint8_t, sizeof(U)>>(rs);
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = (bytes[i] == 0 ? 0 : UINT8_MAX);
+    return std::bit_cast<U>(bytes);
+}
+
+template <class U>
+static inline U ref_rev8(U rs) {
+    U   rd        = 0;
+    int num_bytes = sizeof(U);
+    for (int i = 0; i < num_bytes; i++) {
+        uint8_t byte = (rs >> (i * 8)) & 0xFF;
+        rd |= ((U)byte) << ((num_bytes - 1 - i) * 8);
+    }
+    return rd;
+}
+
+template <class U>
+static inline U ref_clmul(U v1, U v2) {
+    U val = 0;
+    for (unsigned i = 0; i < sizeof(U) * 8; ++i)
+        if ((v2 >> i) & 1)
+            val ^= v1 << i;
+    return val;
+}
+
+template <class U>
+static inline U ref_clmulh(U v1, U v2) {
+    U val = 0;
+    for (unsigned i = 1; i < sizeof(U) * 8; ++i)
+        if ((v2 >> i) & 1)
+            val ^= v1 >> (sizeof(U) * 8 - i);
+    return val;
+}
+
+template <class U>
+static inline U ref_clmulr(U v1, U v2) {
+    U val = 0;
+    for (unsigned i = 0; i < sizeof(U) * 8; ++i)
+        if ((v2 >> i) & 1)
+            val ^= v1 >> (sizeof(U) * 8 - i - 1);
+    return val;
+}
+
+template <class U>
+static inline U host_orc_b(U rs) {
+    if constexpr (sizeof(U) > 8) {
+        return ref_orc_b(rs);
+    } else {
+#ifdef BITMANIP_HOST_X86
+        __m128i zero = _mm_cmpeq_epi8(_mm_cvtsi64_si128((int64_t)rs), _mm_setzero_si128());
+        return U(_mm_cvtsi128_si64(_mm_andnot_si128(zero, _mm_set1_epi8(-1))));
+#else
+        /* top bit of each byte set when any bit of the byte is */
+        const U lo7 = U(0x7f7f7f7f7f7f7f7full);
+        U       t   = (((rs & lo7) + lo7) | rs) & ~lo7;
+        return (t >> 7) * 0xff;
+#endif
+    }
+}
+
+template <class U>
+static inline U host_rev8(U rs) {
+    if constexpr (sizeof(U) == 4)
+        return __builtin_bswap32(rs);
+    else if constexpr (sizeof(U) == 8)
+        return __builtin_bswap64(rs);
+    else
+        return ref_rev8(rs);
+}
+
+#ifdef BITMANIP_HOST_X86
+#ifdef __PCLMUL__
+static inline bool host_has_pclmul() { return true; }
+#else
+static bool host_has_pclmul() {
+    static const bool has = (__builtin_cpu_init(), __builtin_cpu_supports("pclmul"));
+    return has;
+}
+#endif
+
+/* The 128 bit carry-less product of two 64 bit operands, low half first */
+__attribute__((target("pclmul"))) static inline void host_clmul128(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi) {
+    __m128i p = _mm_clmulepi64_si128(_mm_cvtsi64_si128((int64_t)a), _mm_cvtsi64_si128((int64_t)b), 0);
+    *lo       = _mm_cvtsi128_si64(p);
+    *hi       = _mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+}
+#endif
+
+/* part 0: low XLEN bits of the product (clmul), 1: high (clmulh),
+ * 2: bits 2*XLEN-2..XLEN-1 (clmulr) */
+template <int PART, class U>
+static inline U host_clmul_part(U v1, U v2) {
+#ifdef BITMANIP_HOST_X86
+    if constexpr (sizeof(U) <= 8) {
+        if (host_has_pclmul()) {
+            uint64_t lo, hi;
+            host_clmul128(uint64_t(v1), uint64_t(v2), &lo, &hi);
+            if (PART == 0)
+                return U(lo);
+            if constexpr (sizeof(U) == 4)  // the product fits in lo
+                return U(lo >> (PART == 1 ? 32 : 31));
+            else
+                return PART == 1 ? hi : hi << 1 | lo >> 63;
+        }
+    }
+#endif
+    if (PART == 0)
+        return ref_clmul(v1, v2);
+    if (PART == 1)
+        return ref_clmulh(v1, v2);
+    return ref_clmulr(v1, v2);
+}
+
+template <class U>
+static inline U host_clmul(U v1, U v2) {
+    return host_clmul_part<0>(v1, v2);
+}
+
+template <class U>
+static inline U host_clmulh(U v1, U v2) {
+    return host_clmul_part<1>(v1, v2);
+}
+
+template <class U>
+static inline U host_clmulr(U v1, U v2) {
+    return host_clmul_part<2>(v1, v2);
+}
+
+#endif /* BITMANIP_HOST_H */
@@ -202,6 +202,8 @@ void dbuf_putc(DynBuf *s, uint8_t c);
 void dbuf_putstr(DynBuf *s, const char *str);
 void dbuf_free(DynBuf *s);
 
+long get_peak_rss_kib(void);
+
 
 static inline double get_current_time_in_seconds(void) {
     struct timespec ts;
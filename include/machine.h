@@ -173,10 +173,19 @@ typedef struct {
     /* Clear mimpid, marchid, mvendorid */
     bool clear_ids;
 
+    /* Vector register width and widest element, in bits */
+    uint64_t vlen;
+    uint64_t elen;
+
+    /* ISA_EXT_ bits of --march, an interpreter profile has exactly these */
+    uint32_t isa_ext;
+
     uint64_t physical_addr_len;
 
     char *logfile;  // If non-zero, all output goes here, stderr and stdout
 
+    char *live_cache_config;  // LiveCache hierarchy description, JSON
+
     bool dump_memories;
 } VirtMachineParams;
 
@@ -209,10 +218,30 @@ typedef struct VirtMachine {
     bool        simpoint_en_bbv = false;          // Enable simpoint bb generation
     const char* simpoint_bb_file = nullptr;       // simpoint.bbv file name
     uint64_t    simpoint_size = 0;
+    bool        simpoint_roi_at_reset = false;    // Collect from reset, do not wait for the ROI marker
+    bool        simpoint_cluster = false;         // Cluster the bbvs in-tree at the end of the run
+    bool        simpoint_auto = false;            // bbv + cluster, then checkpoint in a second pass
+    int         simpoint_maxk = 30;               // Max k for k-means
+    int         simpoint_dim = 15;                // Random projection dimensions
+    int         simpoint_threads = 0;             // Clustering threads, 0 is one per host cpu
+    const char* simpoint_out = nullptr;           // <prefix>.simpoints/<prefix>.weights
+    int         checkpoint_async = 0;             // Max background checkpoint writers, 0 is blocking
+    bool        warmup_preload = false;           // Consumer pre-loads <checkpoint>.warmup, skip the replay
+    uint64_t    live_cache_window = 0;            // Track the last n instructions before a checkpoint, 0 is from reset
+    bool        live_cache_ffwd = false;          // Outside the window, run the fast-forward engine
 
     // Control
     uint64_t    num_executed = 0;                 // Total number of instructions executed
 
+    // Fast-forward engine, runs until ffwd_until_insns or ffwd_until_pc
+    // then switches to the instrumented engine for the rest of the run
+    bool        ffwd = false;                     // Fast-forward engine is selected
+    uint64_t    ffwd_until_insns = 0;             // Switch at this instruction count, 0 is unused
+    uint64_t    ffwd_until_pc = UINT64_MAX;       // Switch when this PC is reached
+
+    const char* stats_file = nullptr;             // End of run stats, JSON
+    bool        cpu_layout = false;               // End of run RISCVCPUState layout and access counts
+
     // ---------------------------------------------------------------------
     // STF Trace Generation - params
     const char* stf_trace = nullptr;                // STF trace file name
@@ -243,6 +272,7 @@ typedef struct VirtMachine {
     bool cosim;
     int  pending_interrupt;
     int  pending_exception;
+    struct CosimAsync *cosim_async = nullptr;  /* Decoupled checking queue, null when stepping inline */
 
     /* Central logging facility, so far only used in majordomo_cosim */
     majordomo_logging_func_t *error_log;
@@ -292,8 +322,10 @@ extern "C" {
 RISCVMachine *virt_machine_main(int argc, char **argv);
 void          virt_machine_end(RISCVMachine *s);
 void          virt_machine_serialize(RISCVMachine *m, const char *dump_name);
+void          virt_machine_serialize_async(RISCVMachine *m, const char *dump_name);
+void          virt_machine_serialize_wait(RISCVMachine *m, int max_outstanding);
 void          virt_machine_deserialize(RISCVMachine *m, const char *dump_name);
-BOOL          virt_machine_run(RISCVMachine *m, int hartid, int n_cycles);
+BOOL          virt_machine_run(RISCVMachine *m, int hartid, int n_cycles, int *n_executed);
 uint64_t      virt_machine_get_pc(RISCVMachine *m, int hartid);
 uint64_t      virt_machine_get_reg(RISCVMachine *m, int hartid, int rn);
 uint64_t      virt_machine_get_fpreg(RISCVMachine *m, int hartid, int rn);
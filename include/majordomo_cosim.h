@@ -22,6 +22,10 @@
 
 #include "machine.h"
 
+#ifdef GOLDMEM
+#include "bridge_ooo.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -60,6 +64,36 @@ void majordomo_cosim_fini(majordomo_cosim_state_t *state);
 int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t dut_pc, uint32_t dut_insn, uint64_t dut_wdata,
                        uint64_t mstatus, bool check);
 
+/*
+ * One retired instruction as reported by the DUT, see
+ * majordomo_cosim_step() for the fields.
+ */
+typedef struct majordomo_cosim_commit_st {
+    uint64_t pc;
+    uint64_t wdata;
+    uint64_t mstatus;
+    uint32_t insn;
+} majordomo_cosim_commit_t;
+
+/*
+ * majordomo_cosim_step_array --
+ *
+ * Steps through n commit records of one hart, in order, with a single
+ * call instead of one majordomo_cosim_step() call per record.  This only
+ * saves the per-record call from the DUT side: each record is still
+ * executed and checked as one majordomo_cosim_step(), so the
+ * instruction rate of the reference model does not change.  Stops at
+ * the first record with a non-zero result and returns it, zero when all
+ * n matched.  *n_done is set to the index of that record, n when all
+ * matched, so the DUT knows exactly which commit failed (in decoupled
+ * mode the failure may be from an earlier array, see
+ * majordomo_cosim_async_drain()).  Traps raised
+ * with majordomo_cosim_raise_trap() apply to the first record of the
+ * array, so a DUT should end an array at each trap.
+ */
+int majordomo_cosim_step_array(majordomo_cosim_state_t *state, int hartid, const majordomo_cosim_commit_t *commits, int n,
+                             bool check, int *n_done);
+
 /*
  * majordomo_cosim_raise_trap --
  *
@@ -76,10 +110,52 @@ void majordomo_cosim_raise_trap(majordomo_cosim_state_t *state, int hartid, int6
  */
 int majordomo_cosim_override_mem(majordomo_cosim_state_t *state, int hartid, uint64_t dut_paddr, uint64_t dut_val, int size_log2);
 
+/*
+ * majordomo_cosim_async_start --
+ *
+ * Switches to decoupled checking.  From here on majordomo_cosim_step(),
+ * majordomo_cosim_step_array(), majordomo_cosim_raise_trap() and
+ * majordomo_cosim_override_mem() push into a queue of depth entries
+ * (rounded up to a power of two) and return at once, and a majordomo
+ * thread executes and checks the queue in order.  The DUT only stalls
+ * when the queue is full.  The step calls then return the first
+ * non-zero result seen so far, which may belong to an earlier commit;
+ * majordomo_cosim_async_drain() gives its exact index.  All calls must
+ * come from one DUT thread.  The debug and error loggers are called from
+ * the checking thread while it runs, see majordomo_install_new_loggers().
+ * Returns zero on success, -1 if already running or depth is not
+ * positive.
+ */
+int majordomo_cosim_async_start(majordomo_cosim_state_t *state, int depth);
+
+/*
+ * majordomo_cosim_async_drain --
+ *
+ * Waits until every queued entry has been checked.  Returns the first
+ * non-zero step result, zero if everything matched, and sets
+ * *fail_index to the index of that commit counted from
+ * majordomo_cosim_async_start(), over all harts.
+ */
+int majordomo_cosim_async_drain(majordomo_cosim_state_t *state, uint64_t *fail_index);
+
+/*
+ * majordomo_cosim_async_stop --
+ *
+ * Drains the queue like majordomo_cosim_async_drain(), then stops the
+ * checking thread and goes back to stepping inline.
+ * majordomo_cosim_fini() stops it too.
+ */
+int majordomo_cosim_async_stop(majordomo_cosim_state_t *state, uint64_t *fail_index);
+
 /*
  * majordomo_install_new_loggers --
  *
- * Sets logging/error functions.
+ * Sets logging/error functions.  Call it from the DUT thread.  After
+ * majordomo_cosim_async_start() the loggers run on the checking thread,
+ * so this first waits for the queued entries to be checked, as
+ * majordomo_cosim_async_drain() does, and the old loggers are not called
+ * once it returns.  The loggers themselves must be safe to call from
+ * that thread.
  */
 void majordomo_install_new_loggers(majordomo_cosim_state_t *state, majordomo_logging_func_t *debug_log,
                                  majordomo_logging_func_t *error_log);
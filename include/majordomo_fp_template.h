@@ -63,6 +63,9 @@
   However, some of the instruction below are operating on two formats
   at once and care must applied to only use box() upon generic
   arguments (that is, values that depend on F_SIZE)
+
+  write_fp_reg() marks FS dirty, only the ops with an x register result
+  do it themselves, for fflags.
 */
 
 #define unbox      glue(f_unbox, F_SIZE)
@@ -74,7 +77,6 @@ case (0x00 << 2) | OPID:
         goto illegal_insn;
     write_fp_reg(rd,
                  glue(add_sf, F_SIZE)(unbox(read_fp_reg(rs1)), unbox(read_fp_reg(rs2)), (RoundingModeEnum)rm, &s->fflags) | F_HIGH);
-    s->fs = 3;
     break;
 case (0x01 << 2) | OPID:
     rm = get_insn_rm(s, rm);
@@ -82,7 +84,6 @@ case (0x01 << 2) | OPID:
         goto illegal_insn;
     write_fp_reg(rd,
                  glue(sub_sf, F_SIZE)(unbox(read_fp_reg(rs1)), unbox(read_fp_reg(rs2)), (RoundingModeEnum)rm, &s->fflags) | F_HIGH);
-    s->fs = 3;
     break;
 case (0x02 << 2) | OPID:
     rm = get_insn_rm(s, rm);
@@ -90,7 +91,6 @@ case (0x02 << 2) | OPID:
         goto illegal_insn;
     write_fp_reg(rd,
                  glue(mul_sf, F_SIZE)(unbox(read_fp_reg(rs1)), unbox(read_fp_reg(rs2)), (RoundingModeEnum)rm, &s->fflags) | F_HIGH);
-    s->fs = 3;
     break;
 case (0x03 << 2) | OPID:
     rm = get_insn_rm(s, rm);
@@ -98,14 +98,12 @@ case (0x03 << 2) | OPID:
         goto illegal_insn;
     write_fp_reg(rd,
                  glue(div_sf, F_SIZE)(unbox(read_fp_reg(rs1)), unbox(read_fp_reg(rs2)), (RoundingModeEnum)rm, &s->fflags) | F_HIGH);
-    s->fs = 3;
     break;
 case (0x0b << 2) | OPID:
     rm = get_insn_rm(s, rm);
     if (rm < 0 || rs2 != 0)
         goto illegal_insn;
     write_fp_reg(rd, glue(sqrt_sf, F_SIZE)(unbox(read_fp_reg(rs1)), (RoundingModeEnum)rm, &s->fflags) | F_HIGH);
-    s->fs = 3;
     break;
 case (0x04 << 2) | OPID:
     switch (rm) {
@@ -119,7 +117,6 @@ case (0x04 << 2) | OPID:
         case 2: /* fsgnjx */ write_fp_reg(rd, (unbox(read_fp_reg(rs1)) ^ (unbox(read_fp_reg(rs2)) & FSIGN_MASK)) | F_HIGH); break;
         default: goto illegal_insn;
     }
-    s->fs = 3;
     break;
 case (0x05 << 2) | OPID:
     switch (rm) {
@@ -131,7 +128,6 @@ case (0x05 << 2) | OPID:
             break;
         default: goto illegal_insn;
     }
-    s->fs = 3;
     break;
 case (0x18 << 2) | OPID:
     rm = get_insn_rm(s, rm);
@@ -188,7 +184,6 @@ case (0x1a << 2) | OPID:
 #endif
         default: goto illegal_insn;
     }
-    s->fs = 3;
     break;
 
 case (0x08 << 2) | OPID:
@@ -227,7 +222,6 @@ case (0x08 << 2) | OPID:
 
         default: goto illegal_insn;
     }
-    s->fs = 3;
     break;
 
 case (0x1c << 2) | OPID:
@@ -263,7 +257,6 @@ case (0x1e << 2) | OPID: /* fmv.w.x */
 #else
     write_fp_reg(rd, (int128_t)read_reg(rs1) | F_HIGH);
 #endif
-    s->fs = 3;
     break;
 #endif /* F_SIZE <= XLEN */
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// In-tree SimPoint clustering.
+//
+// BBV intervals collected by simpoint_step() are reduced with a random
+// linear projection and clustered with k-means for k = 1..maxk. The k is
+// picked with the Bayesian Information Criterion the same way the SimPoint
+// tool does: the smallest k whose BIC is within bic_ratio of the best.
+// One representative interval (closest to its centroid) is kept per cluster.
+//
+// The output files use the SimPoint 3.x format, so they can be fed back to
+// --simpoint unchanged:
+//
+//   simpoints: <interval> <cluster id>
+//   weights:   <weight>   <cluster id>
+//
+#pragma once
+
+#include "machine.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// One BBV interval, sparse (basic block id, instruction count) pairs
+// -------------------------------------------------------------------------
+struct SimpointBbv {
+    std::vector<std::pair<uint32_t, uint64_t>> bb;
+};
+
+// -------------------------------------------------------------------------
+// Clustering knobs, defaults follow the SimPoint tool
+// -------------------------------------------------------------------------
+struct SimpointClusterParams {
+    int      max_k       = 30;
+    int      dim         = 15;    // random projection dimensions
+    int      num_seeds   = 5;     // k-means restarts per k
+    int      max_iter    = 100;   // Lloyd iterations per restart
+    int      num_threads = 0;     // 0 = std::thread::hardware_concurrency()
+    double   bic_ratio   = 0.9;
+    uint64_t seed        = 493575226;
+};
+
+// -------------------------------------------------------------------------
+// A selected simulation point
+// -------------------------------------------------------------------------
+struct SimpointPick {
+    uint64_t interval;
+    int      id;
+    double   weight;
+};
+
+extern std::vector<SimpointPick> simpoint_cluster(
+                                   const std::vector<SimpointBbv> &intervals,
+                                   const SimpointClusterParams &params);
+
+extern bool simpoint_write(const std::vector<SimpointPick> &picks,
+                           const char *simpoints_name,
+                           const char *weights_name);
+
+// Append a checkpoint request at interval * simpoint_size. Callers sort
+// vm->simpoints once all entries are added.
+extern void simpoint_add(VirtMachine *vm, uint64_t interval, int id);
@@ -56,18 +56,19 @@
 
 #include "majordomo_stf.h"
 #include "majordomo_protos.h"
+#include "bitmanip_host.h"
 #include <limits>
 
-//#define EN_ZBA (s->machine->common.ext_flags.zba == true)
-//#define EN_ZBB (s->machine->common.ext_flags.zbb == true)
-//#define EN_ZBC (s->machine->common.ext_flags.zbb == true)
-//#define EN_ZBS (s->machine->common.ext_flags.zbs == true)
-
-#define EN_ZICOND 1
-#define EN_ZBA 1
-#define EN_ZBB 1
-#define EN_ZBC 1
-#define EN_ZBS 1
+// Constants of each interpreter instance, ISA is its profile (riscv_isa.h).
+// A disabled extension folds its decode tests away and its encodings fall
+// through to illegal_insn.
+#define EN_C      ((ISA & ISA_EXT_C) != 0)
+#define EN_V      ((ISA & ISA_EXT_V) != 0)
+#define EN_ZICOND ((ISA & ISA_EXT_ZICOND) != 0)
+#define EN_ZBA    ((ISA & ISA_EXT_ZBA) != 0)
+#define EN_ZBB    ((ISA & ISA_EXT_ZBB) != 0)
+#define EN_ZBC    ((ISA & ISA_EXT_ZBC) != 0)
+#define EN_ZBS    ((ISA & ISA_EXT_ZBS) != 0)
 
 #define _GP 0x3
 //TODO: modify src to use this instead of cond. compile
@@ -137,23 +138,11 @@ static inline uint32_t shift_mask()
 // =========================================================================
 // =========================================================================
 static inline uintx_t glue(orc_b,XLEN)(uintx_t rs) {
-  auto bytes = std::bit_cast<std::array<uint8_t, sizeof(uintx_t)>>(rs);
-  for (size_t i = 0; i < bytes.size(); i++) {
-    bytes[i] = (bytes[i] == 0 ? 0 : UINT8_MAX);
-  }
-  uintx_t rd = std::bit_cast<uintx_t>(bytes);
-  return rd;
+  return host_orc_b(rs);
 }
 // -------------------------------------------------------------------------
 static inline uintx_t glue(rev8,XLEN)(uintx_t rs) {
-  uintx_t rd = 0;
-  int num_bytes = sizeof(uintx_t);
-  // Reverse the bytes
-  for (int i = 0; i < num_bytes; i++) {
-      uint8_t byte = (rs >> (i * 8)) & 0xFF;
-      rd |= ((uintx_t)byte) << ((num_bytes - 1 - i) * 8);
-  }
-  return rd;
+  return host_rev8(rs);
 }
 // -------------------------------------------------------------------------
 static inline uintx_t glue(rol,XLEN)(uintx_t rs1,uintx_t rs2) {
@@ -283,29 +272,17 @@ static inline uint64_t remu64(uint64_t a, uint64_t b) {
 // =========================================================================
 static inline uintx_t glue(clmul,XLEN)(uintx_t v1,uintx_t v2) {
     assert(XLEN == 32 || XLEN == 64 || XLEN == 128);
-
-    uintx_t val = 0;
-    for (unsigned i = 0; i < XLEN; ++i)
-        if ((v2 >> i) & 1) val ^= v1 << i;
-    return val;
+    return host_clmul(v1, v2);
 }
 // -------------------------------------------------------------------------
 static inline uintx_t glue(clmulh,XLEN)(uintx_t v1,uintx_t v2) {
     assert(XLEN == 32 || XLEN == 64 || XLEN == 128);
-
-    uintx_t val = 0;
-    for (unsigned i = 1; i < XLEN; ++i)
-        if ((v2 >> i) & 1) val ^= v1 >> (XLEN - i);
-    return val;
+    return host_clmulh(v1, v2);
 }
 // -------------------------------------------------------------------------
 static inline uintx_t glue(clmulr,XLEN)(uintx_t v1,uintx_t v2) {
     assert(XLEN == 32 || XLEN == 64 || XLEN == 128);
-
-    uintx_t val = 0;
-    for (unsigned i = 0; i < XLEN; ++i)
-        if ((v2 >> i) & 1) val ^= v1 >> (XLEN - i - 1);
-    return val;
+    return host_clmulr(v1, v2);
 }
 // -------------------------------------------------------------------------
 static inline uintx_t glue(cpop,XLEN)(uintx_t val) {
@@ -521,8 +498,8 @@ static inline uintx_t glue(mulhsu, XLEN)(intx_t a, uintx_t b) {
 
 #define chkfp32 glue(chkfp32, XLEN)
 
-static uint32_t chkfp32(target_ulong a) {
-    if ((a & 0xFFFFFFFF00000000ULL) != 0xFFFFFFFF00000000ULL)
+static uint32_t chkfp32(fp_uint a) {
+    if ((a & F32_HIGH) != F32_HIGH)
         return -1U << 22;  // Not boxed => return float32 QNAN
 
     return (uint32_t)a;
@@ -539,8 +516,14 @@ static uint32_t chkfp32(target_ulong a) {
  */
 
 int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles);
-
-int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
+int no_inline glue(riscv_cpu_interp_ffwd, XLEN)(RISCVCPUState *s, int n_cycles);
+
+// FFWD selects the fast-forward engine: register/memory observers, last_pc
+// and the LiveCache hooks are compiled out, and the loop stops at
+// common.ffwd_until_pc. Only architectural state is maintained.
+// ISA is the set of ISA_EXT_ bits of the profile the instance decodes.
+template <bool FFWD, uint32_t ISA>
+static int glue(riscv_cpu_interp_impl, XLEN)(RISCVCPUState *s, int n_cycles) {
     uint32_t     opcode, insn, rd, rs1, rs2, funct2, funct3;
     uint32_t     _funct3, _funct6, _funct7, _funct12, _shamt5, _shamt6, _shamt;
     int32_t      imm, cond, err;
@@ -601,11 +584,18 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
     /* we use a single execution loop to keep a simple control flow
        for emscripten */
     for (;;) {
-        s->last_pc = s->pc;
+        if constexpr (!FFWD)
+            s->last_pc = s->pc;
         s->pc = GET_PC();
+        CPU_FIELD_HIT(s, pc);
         if (unlikely(!--n_cycles))
             goto the_end;
 
+        if constexpr (FFWD) {
+            if (unlikely(s->pc == s->machine->common.ffwd_until_pc))
+                goto the_end;
+        }
+
         ++insn_executed;
 
         if (check_triggers(s, MCONTROL_EXECUTE, s->pc))
@@ -625,6 +615,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
 
             addr    = s->pc;
             tlb_idx = (addr >> PG_SHIFT) & (TLB_SIZE - 1);
+            CPU_FIELD_HIT(s, tlb_code[tlb_idx]);
             if (likely(s->tlb_code[tlb_idx].vaddr == (addr & ~PG_MASK))) {
                 /* TLB match */
                 uintptr_t mem_addend;
@@ -706,6 +697,8 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
 
             // --------------------------------------------------------------
             C_QUADRANT(0)
+            if constexpr (!EN_C)
+                ILLEGAL_INSTR("C")
             funct3 = (insn >> 13) & 7;
             rd     = ((insn >> 2) & 7) | 8;
             switch (funct3) {
@@ -722,7 +715,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
                     s->last_addr = addr;
-                    if (target_read_u128(s, &val, addr))
+                    if (target_read_u128<FFWD>(s, &val, addr))
                         goto mmu_exception;
                     write_reg(rd, val);
                     break;
@@ -735,7 +728,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 5, 6, 7);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_read_u64(s, &rval, addr))
+                    if (target_read_u64<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_fp_reg(rd, rval | F64_HIGH);
                 } break;
@@ -746,7 +739,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 6, 2, 2) | get_field1(insn, 5, 6, 6);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_read_u32(s, &rval, addr))
+                    if (target_read_u32<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_reg(rd, (int32_t)rval);
                 } break;
@@ -757,7 +750,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 5, 6, 7);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_read_u64(s, &rval, addr))
+                    if (target_read_u64<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_reg(rd, (int64_t)rval);
                 } break;
@@ -770,7 +763,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 6, 2, 2) | get_field1(insn, 5, 6, 6);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_read_u32(s, &rval, addr))
+                    if (target_read_u32<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_fp_reg(rd, rval | F32_HIGH);
                 } break;
@@ -781,7 +774,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
                     val  = read_reg(rd);
-                    if (target_write_u128(s, addr, val))
+                    if (target_write_u128<FFWD>(s, addr, val))
                         goto mmu_exception;
                     break;
 #elif FLEN >= 64
@@ -791,7 +784,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 5, 6, 7);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_write_u64(s, addr, read_fp_reg(rd)))
+                    if (target_write_u64<FFWD>(s, addr, read_fp_reg(rd)))
                         goto mmu_exception;
                     break;
 #endif
@@ -800,7 +793,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
                     val  = read_reg(rd);
-                    if (target_write_u32(s, addr, val))
+                    if (target_write_u32<FFWD>(s, addr, val))
                         goto mmu_exception;
                     break;
 #if XLEN >= 64
@@ -809,7 +802,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
                     val  = read_reg(rd);
-                    if (target_write_u64(s, addr, val))
+                    if (target_write_u64<FFWD>(s, addr, val))
                         goto mmu_exception;
                     break;
 #elif FLEN >= 32
@@ -819,7 +812,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 6, 2, 2) | get_field1(insn, 5, 6, 6);
                     rs1  = ((insn >> 7) & 7) | 8;
                     addr = (intx_t)(read_reg(rs1) + imm);
-                    if (target_write_u32(s, addr, read_fp_reg(rd)))
+                    if (target_write_u32<FFWD>(s, addr, read_fp_reg(rd)))
                         goto mmu_exception;
                     break;
 #endif
@@ -827,6 +820,8 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
             }
             C_NEXT_INSN;
             C_QUADRANT(1)
+            if constexpr (!EN_C)
+                ILLEGAL_INSTR("C")
             funct3 = (insn >> 13) & 7;
             switch (funct3) {
                 case 0: /* c.addi/c.nop */
@@ -949,6 +944,8 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
             }
             C_NEXT_INSN;
             C_QUADRANT(2)
+            if constexpr (!EN_C)
+                ILLEGAL_INSTR("C")
             funct3 = (insn >> 13) & 7;
             rs2    = (insn >> 2) & 0x1f;
             switch (funct3) {
@@ -969,7 +966,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("014")
                     imm  = get_field1(insn, 12, 5, 5) | (rs2 & (1 << 4)) | get_field1(insn, 2, 6, 9);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_read_u128(s, &val, addr))
+                    if (target_read_u128<FFWD>(s, &val, addr))
                         goto mmu_exception;
                     if (rd != 0)
                         write_reg(rd, val);
@@ -982,7 +979,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("015")
                     imm  = get_field1(insn, 12, 5, 5) | (rs2 & (3 << 3)) | get_field1(insn, 2, 6, 8);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_read_u64(s, &rval, addr))
+                    if (target_read_u64<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_fp_reg(rd, rval | F64_HIGH);
                 } break;
@@ -994,7 +991,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("016")
                     imm  = get_field1(insn, 12, 5, 5) | (rs2 & (7 << 2)) | get_field1(insn, 2, 6, 7);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_read_u32(s, &rval, addr))
+                    if (target_read_u32<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_reg(rd, (int32_t)rval);
                 } break;
@@ -1006,7 +1003,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("017")
                     imm  = get_field1(insn, 12, 5, 5) | (rs2 & (3 << 3)) | get_field1(insn, 2, 6, 8);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_read_u64(s, &rval, addr))
+                    if (target_read_u64<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_reg(rd, (int64_t)rval);
                 } break;
@@ -1018,7 +1015,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("018")
                     imm  = get_field1(insn, 12, 5, 5) | (rs2 & (7 << 2)) | get_field1(insn, 2, 6, 7);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_read_u32(s, &rval, addr))
+                    if (target_read_u32<FFWD>(s, &rval, addr))
                         goto mmu_exception;
                     write_fp_reg(rd, rval | F32_HIGH);
                 } break;
@@ -1060,7 +1057,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                 case 5: /* c.sqsp */
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 7, 6, 8);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_write_u128(s, addr, read_reg(rs2)))
+                    if (target_write_u128<FFWD>(s, addr, read_reg(rs2)))
                         goto mmu_exception;
                     break;
 #elif FLEN >= 64
@@ -1069,21 +1066,21 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("020")
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 7, 6, 8);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_write_u64(s, addr, read_fp_reg(rs2)))
+                    if (target_write_u64<FFWD>(s, addr, read_fp_reg(rs2)))
                         goto mmu_exception;
                     break;
 #endif
                 case 6: /* c.swsp */
                     imm  = get_field1(insn, 9, 2, 5) | get_field1(insn, 7, 6, 7);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_write_u32(s, addr, read_reg(rs2)))
+                    if (target_write_u32<FFWD>(s, addr, read_reg(rs2)))
                         goto mmu_exception;
                     break;
 #if XLEN >= 64
                 case 7: /* c.sdsp */
                     imm  = get_field1(insn, 10, 3, 5) | get_field1(insn, 7, 6, 8);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_write_u64(s, addr, read_reg(rs2)))
+                    if (target_write_u64<FFWD>(s, addr, read_reg(rs2)))
                         goto mmu_exception;
                     break;
 #elif FLEN >= 32
@@ -1092,7 +1089,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         ILLEGAL_INSTR("021")
                     imm  = get_field1(insn, 9, 2, 5) | get_field1(insn, 7, 6, 7);
                     addr = (intx_t)(read_reg(2) + imm);
-                    if (target_write_u32(s, addr, read_fp_reg(rs2)))
+                    if (target_write_u32<FFWD>(s, addr, read_fp_reg(rs2)))
                         goto mmu_exception;
                     break;
 #endif
@@ -1176,35 +1173,35 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 0: /* lb */
                     {
                         uint8_t rval;
-                        if (target_read_u8(s, &rval, addr))
+                        if (target_read_u8<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = (int8_t)rval;
                     } break;
                     case 1: /* lh */
                     {
                         uint16_t rval;
-                        if (target_read_u16(s, &rval, addr))
+                        if (target_read_u16<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = (int16_t)rval;
                     } break;
                     case 2: /* lw */
                     {
                         uint32_t rval;
-                        if (target_read_u32(s, &rval, addr))
+                        if (target_read_u32<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = (int32_t)rval;
                     } break;
                     case 4: /* lbu */
                     {
                         uint8_t rval;
-                        if (target_read_u8(s, &rval, addr))
+                        if (target_read_u8<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = rval;
                     } break;
                     case 5: /* lhu */
                     {
                         uint16_t rval;
-                        if (target_read_u16(s, &rval, addr))
+                        if (target_read_u16<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = rval;
                     } break;
@@ -1212,14 +1209,14 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 3: /* ld */
                     {
                         uint64_t rval;
-                        if (target_read_u64(s, &rval, addr))
+                        if (target_read_u64<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = (int64_t)rval;
                     } break;
                     case 6: /* lwu */
                     {
                         uint32_t rval;
-                        if (target_read_u32(s, &rval, addr))
+                        if (target_read_u32<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = rval;
                     } break;
@@ -1228,7 +1225,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 7: /* ldu */
                     {
                         uint64_t rval;
-                        if (target_read_u64(s, &rval, addr))
+                        if (target_read_u64<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         val = rval;
                     } break;
@@ -1247,26 +1244,26 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
 
                 switch (funct3) {
                     case 0: /* sb */
-                        if (target_write_u8(s, addr, val))
+                        if (target_write_u8<FFWD>(s, addr, val))
                             goto mmu_exception;
                         break;
                     case 1: /* sh */
-                        if (target_write_u16(s, addr, val))
+                        if (target_write_u16<FFWD>(s, addr, val))
                             goto mmu_exception;
                         break;
                     case 2: /* sw */
-                        if (target_write_u32(s, addr, val))
+                        if (target_write_u32<FFWD>(s, addr, val))
                             goto mmu_exception;
                         break;
 #if XLEN >= 64
                     case 3: /* sd */
-                        if (target_write_u64(s, addr, val))
+                        if (target_write_u64<FFWD>(s, addr, val))
                             goto mmu_exception;
                         break;
 #endif
 #if XLEN >= 128
                     case 4: /* sq */
-                        if (target_write_u128(s, addr, val))
+                        if (target_write_u128<FFWD>(s, addr, val))
                             goto mmu_exception;
                         break;
 #endif
@@ -2008,7 +2005,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 2: /* lq */
                         imm  = (int32_t)insn >> 20;
                         addr = read_reg(rs1) + imm;
-                        if (target_read_u128(s, &val, addr))
+                        if (target_read_u128<FFWD>(s, &val, addr))
                             goto mmu_exception;
                         if (rd != 0)
                             write_reg(rd, val);
@@ -2028,7 +2025,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
             case 2: /* lr.w/lr.d */                                                     \
                 if (rs2 != 0)                                                           \
                     goto illegal_insn;                                                  \
-                if (target_read_u##size(s, &rval, addr))                                \
+                if (target_read_u##size<FFWD>(s, &rval, addr))                                \
                     goto mmu_exception;                                                 \
                 val         = (int##size##_t)rval;                                      \
                 s->load_res = addr;                                                     \
@@ -2042,7 +2039,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     goto mmu_exception;                                                 \
                 }                                                                       \
                 if (s->load_res == addr && s->load_res_memseqno == s->machine->memseqno) { \
-                    if (target_write_u##size(s, addr, read_reg(rs2)))                   \
+                    if (target_write_u##size<FFWD>(s, addr, read_reg(rs2)))                   \
                         goto mmu_exception;                                             \
                     val         = 0;                                                    \
                     s->load_res = ~0;                                                   \
@@ -2060,7 +2057,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
             case 0x14: /* amomax.w */                                                   \
             case 0x18: /* amominu.w */                                                  \
             case 0x1c: /* amomaxu.w */                                                  \
-                if (target_read_u##size(s, &rval, addr)) {                              \
+                if (target_read_u##size<FFWD>(s, &rval, addr)) {                              \
                     if (s->pending_exception != CAUSE_BREAKPOINT)                       \
                         s->pending_exception += 2; /* LD -> ST */                       \
                     goto mmu_exception;                                                 \
@@ -2091,7 +2088,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         break;                                                          \
                     default: goto illegal_insn;                                         \
                 }                                                                       \
-                if (target_write_u##size(s, addr, val2))                                \
+                if (target_write_u##size<FFWD>(s, addr, val2))                                \
                     goto mmu_exception;                                                 \
                 break;                                                                  \
             default: goto illegal_insn;                                                 \
@@ -2122,7 +2119,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         if (s->fs == 0)
                             ILLEGAL_INSTR("068")
                         uint32_t rval;
-                        if (target_read_u32(s, &rval, addr))
+                        if (target_read_u32<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         write_fp_reg(rd, rval | F32_HIGH);
                     } break;
@@ -2132,7 +2129,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         if (s->fs == 0)
                             ILLEGAL_INSTR("069")
                         uint64_t rval;
-                        if (target_read_u64(s, &rval, addr))
+                        if (target_read_u64<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         write_fp_reg(rd, rval | F64_HIGH);
                     } break;
@@ -2143,7 +2140,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                         if (s->fs == 0)
                             ILLEGAL_INSTR("070")
                         uint128_t rval;
-                        if (target_read_u128(s, &rval, addr))
+                        if (target_read_u128<FFWD>(s, &rval, addr))
                             goto mmu_exception;
                         write_fp_reg(rd, rval);
                     } break;
@@ -2155,7 +2152,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 5:
                     case 6:
                     case 7:
-                        if (s->vs == 0)
+                        if (!EN_V || s->vs == 0)
                             ILLEGAL_INSTR("071")
                         vmem_result = vmem_op(s, insn, true, v_load_config);
                         if (vmem_result == 2)
@@ -2179,14 +2176,14 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 2: /* fsw */
                         if (s->fs == 0)
                             ILLEGAL_INSTR("074")
-                        if (target_write_u32(s, addr, read_fp_reg(rs2)))
+                        if (target_write_u32<FFWD>(s, addr, read_fp_reg(rs2)))
                             goto mmu_exception;
                         break;
 #if FLEN >= 64
                     case 3: /* fsd */
                         if (s->fs == 0)
                             ILLEGAL_INSTR("075")
-                        if (target_write_u64(s, addr, read_fp_reg(rs2)))
+                        if (target_write_u64<FFWD>(s, addr, read_fp_reg(rs2)))
                             goto mmu_exception;
                         break;
 #endif
@@ -2194,7 +2191,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 4: /* fsq */
                         if (s->fs == 0)
                             ILLEGAL_INSTR("076")
-                        if (target_write_u128(s, addr, read_fp_reg(rs2)))
+                        if (target_write_u128<FFWD>(s, addr, read_fp_reg(rs2)))
                             goto mmu_exception;
                         break;
 #endif
@@ -2206,7 +2203,7 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                     case 5:
                     case 6:
                     case 7:
-                        if (s->vs == 0)
+                        if (!EN_V || s->vs == 0)
                             ILLEGAL_INSTR("077")
                         vmem_result = vmem_op(s, insn, false, v_store_config);
                         if (vmem_result == 2)
@@ -2512,6 +2509,8 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
 
 #if VLEN > 0
             case 0x57:
+                if constexpr (!EN_V)
+                    ILLEGAL_INSTR("V")
                 if (s->vs == 0)
                     ILLEGAL_INSTR("094")
                 s->vs  = 3;
@@ -2623,7 +2622,8 @@ int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) {
                                 break;
                         }
 
-                        if (get_sew(s) >= VLEN * get_lmul(s) / 8) {  // vector must be more than one elm long
+                        if (get_sew(s) >= s->vlen * get_lmul(s) / 8  // vector must be more than one elm long
+                            || get_sew(s) > s->elen) {
                             s->vtype = VILL;
                             s->vl    = 0;
                         } else if (avl <= get_vlmax(s))
@@ -2702,6 +2702,32 @@ the_end:
     return insn_executed;
 }
 
+template <bool FFWD, uint32_t ISA>
+static int no_inline glue(riscv_cpu_interp_isa, XLEN)(RISCVCPUState *s, int n_cycles) {
+    return glue(riscv_cpu_interp_impl, XLEN)<FFWD, ISA>(s, n_cycles);
+}
+
+#define ISA_INTERP(P) \
+    {glue(riscv_cpu_interp_isa, XLEN)<false, P>, glue(riscv_cpu_interp_isa, XLEN)<true, P>}
+
+/* Indexed like isa_profiles[], see riscv_cpu_init() */
+static const RISCVInterp glue(riscv_interp_profiles, XLEN)[] = {
+    ISA_INTERP(ISA_PROFILE_RV64G),
+    ISA_INTERP(ISA_PROFILE_RV64GB),
+    ISA_INTERP(ISA_PROFILE_RV64GV),
+    ISA_INTERP(ISA_PROFILE_RV64GC),
+    ISA_INTERP(ISA_PROFILE_RV64GCB),
+    ISA_INTERP(ISA_PROFILE_RV64GCV),
+    ISA_INTERP(ISA_PROFILE_RVA23),
+    ISA_INTERP(ISA_PROFILE_ALL),
+};
+
+#undef ISA_INTERP
+
+int no_inline glue(riscv_cpu_interp, XLEN)(RISCVCPUState *s, int n_cycles) { return s->interp->run(s, n_cycles); }
+
+int no_inline glue(riscv_cpu_interp_ffwd, XLEN)(RISCVCPUState *s, int n_cycles) { return s->interp->ffwd(s, n_cycles); }
+
 #undef uintx_t
 #undef intx_t
 #undef XLEN
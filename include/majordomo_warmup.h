@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Checkpoint cache warm set, <checkpoint>.warmup
+//
+// A WARMUP build writes the resident lines of every LiveCache level next
+// to the checkpoint. All integers are little endian.
+//
+//   char     magic[8]        "MDWARMUP"
+//   uint32_t version         1
+//   uint32_t n_levels
+//   per level, core side first
+//     uint32_t name_len, char name[name_len]
+//     uint32_t policy_len, char policy[policy_len]
+//     uint64_t size
+//     uint32_t assoc
+//     uint32_t line_size
+//     uint8_t  side          0 unified, 1 inst, 2 data
+//     uint8_t  inclusion     0 inclusive, 1 exclusive, 2 nine
+//     uint64_t n_lines
+//     uint64_t n_bytes       encoded line stream that follows
+//     n_lines ULEB128 values, least recently used first
+//       (zigzag(line - previous line) << 1) | store
+//
+// line is the address divided by line_size, the first line is relative
+// to 0. Consecutive lines of a streaming working set encode in one byte.
+//
+// The warm set is restored either by a consumer pre-loading it into its own
+// cache model, or by the boot ROM replaying one load or store per line from
+// a RAM region mapped at WARMUP_BASE_ADDR:
+//
+//   uint64_t n_entries, then n_entries addresses, bit 0 set for stores
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Replay region, in the hole between the UART and main RAM
+#define WARMUP_BASE_ADDR 0x60000000
+#define WARMUP_MAX_SIZE  0x20000000
+
+// -------------------------------------------------------------------------
+// One cache level of the warm set
+// -------------------------------------------------------------------------
+struct WarmupLevel {
+    std::string name;
+    std::string policy;
+    uint64_t    size      = 0;
+    uint32_t    assoc     = 0;
+    uint32_t    line_size = 0;
+    uint8_t     side      = 0;
+    uint8_t     inclusion = 0;
+
+    // Line addresses, least recently used first, bit 0 set for stores
+    std::vector<uint64_t> lines;
+};
+
+extern bool warmup_write(const char *file_name, const std::vector<WarmupLevel> &levels);
+extern bool warmup_read(const char *file_name, std::vector<WarmupLevel> &levels);
+
+// Replay order for the boot ROM loop, outermost level first so the lines
+// closest to the core are touched last
+extern std::vector<uint64_t> warmup_replay_list(const std::vector<WarmupLevel> &levels);
@@ -111,13 +111,18 @@ struct Options
   std::string prog{""};
   std::string snapshot_load_name{""};
   std::string snapshot_save_name{""};
+  std::string warmup_restore{"loop"};
   std::string path{""};
   std::string cmdline{""};
   std::string simpoint_file{""};
 
   uint32_t    ncpus{0};
   uint64_t    maxinsns{0};
+  uint64_t    ffwd_until_insns{0};
+  uint64_t    ffwd_until_pc{UINT64_MAX};
   uint64_t    heartbeat{UINT64_MAX};
+  std::string stats_file{""};
+  bool        cpu_layout{false};
 
   uint64_t    exe_trace{UINT64_MAX};
   std::string exe_trace_log{""};
@@ -138,6 +143,14 @@ struct Options
   bool        simpoint_en_bbv{false};
   std::string simpoint_bb_file;
   uint64_t    simpoint_size{0};
+  bool        simpoint_roi_at_reset{false};
+  bool        simpoint_cluster{false};
+  bool        simpoint_auto{false};
+  int         simpoint_maxk{30};
+  int         simpoint_dim{15};
+  int         simpoint_threads{0};
+  std::string simpoint_out{"majordomo_simpoint"};
+  int         checkpoint_async{-1};
 
   uint64_t    memory_size_override{0};
   uint64_t    memory_addr_override{0};
@@ -160,6 +173,9 @@ struct Options
   bool        custom_extension{false};
   bool        clear_ids{false};
 
+  uint64_t    vlen{0};
+  uint64_t    elen{0};
+
 //#ifdef LIVECACHE
 //  uint64_t    live_cache_size{8*1024*1024};
 //#endif
@@ -193,6 +209,8 @@ struct Options
 
   //This is only valid when -DLIVECACHE is supplied during compile
   uint64_t live_cache_size{0x800000};//8MB
+  std::string live_cache_config{""};
+  uint64_t live_cache_window{0};
 
   std::string positional_argument;
 
@@ -98,7 +98,9 @@ typedef uint128_t fp_uint;
 #endif
 #endif
 
-/* VLEN is the vector register width */
+/* VLEN/ELEN are the default vector register width and widest element, a
+ * run can pick others with --vlen/--elen, "vlen"/"elen" in the config or
+ * zvl<N>b/zve<N> in --march. VLEN 0 compiles the V extension out */
 #define IS_PO2(n)    ((n) && ((n) & ((n)-1)) == 0)
 #define ELEN_MIN     (1 << 3)
 #define VLEN_MAX     (1 << 16)
@@ -194,15 +196,44 @@ typedef enum {
     ctf_taken_jalr_pop_push,
 } RISCVCTFInfo;
 
-typedef struct RISCVCPUState {
-    RISCVMachine *machine;
+struct RISCVCPUState;
+
+/* The interpreter loops of one ISA profile, see riscv_cpu_init() */
+struct RISCVInterp {
+    int (*run)(struct RISCVCPUState *s, int n_cycles);
+    int (*ffwd)(struct RISCVCPUState *s, int n_cycles);
+};
+
+/*
+ * Ordered by how often the interpreter loop touches a field. The hot
+ * part, what every instruction reads or writes, is packed into the first
+ * cache lines, the TLBs and the state of memory accesses follow and the
+ * rest is cold. riscv_cpu_print_layout() (--cpu_layout) prints the
+ * offsets and, built with CPU_FIELD_STATS, the access counts per field.
+ */
+typedef struct alignas(64) RISCVCPUState {
+    /* Hot: every instruction */
     target_ulong  pc;
     target_ulong  last_pc;
-    target_ulong  reg[32];
-    /* Co-simulation sometimes need to see the value of a register
-     * prior to the just excuted instruction. */
-    target_ulong reg_prior[32];
-    int          most_recently_written_reg;
+    RISCVMachine *machine;
+    uint64_t      insn_counter;  // Simulator internal
+    int           most_recently_written_reg;
+    int           pending_exception; /* used during MMU exception handling */
+    target_ulong  pending_tval;
+
+    uint8_t priv; /* see PRV_x */
+    uint8_t fs;   /* MSTATUS_FS value */
+    uint8_t vs;   /* MSTATUS_VS value */
+#if FLEN > 0
+    uint8_t  frm;
+    uint32_t fflags;
+    int      most_recently_written_fp_reg;
+#endif
+    BOOL debug_mode;
+
+    /* Control Flow Info */
+    RISCVCTFInfo info;
+    target_ulong next_addr; /* the CFI target address-- only valid for CFIs. */
 
     target_ulong last_data_paddr;
     target_ulong last_data_vaddr = -1;
@@ -212,16 +243,42 @@ typedef struct RISCVCPUState {
     target_ulong last_data_value;
 #endif
 
+    target_ulong tdata1[MAX_TRIGGERS]; /* every fetch and access, see check_triggers() */
+
+    alignas(64) target_ulong reg[32]; /* 4 whole cache lines, fp_reg too at FLEN 64 */
 #if FLEN > 0
-    fp_uint  fp_reg[32];
-    int      most_recently_written_fp_reg;
-    uint32_t fflags;
-    uint8_t  frm;
+    fp_uint fp_reg[32];
 #endif
+    /* Co-simulation sometimes need to see the value of a register
+     * prior to the just excuted instruction. */
+    target_ulong reg_prior[32];
+
+    /* Warm: memory accesses, page crossings and vector instructions */
+    uint32_t     mie;
+    uint32_t     mip;
+    target_ulong mstatus;
+
+    /*
+     * "The SC must fail if a store to the reservation set from
+     * another hart can be observed to occur between the LR and SC."
+     *
+     * To achieve this in a scalable and low-overhead way we maintain
+     * a sequence number for global memory and one per reservation.
+     * As long as the reservation tracks the global number, we know no
+     * other hart has written memory.
+     */
+    target_ulong load_res; /* for atomic LR/SC */
+    uint64_t     load_res_memseqno;
+
+    const RISCVInterp *interp; /* specialized for the ISA profile */
 
 #if VLEN > 0
-    uint8_t  v_reg[32][VLEN / 8];
+    uint8_t *v_reg[32]; /* rows of one vlen / 8 * 32 byte block */
     bool     most_recently_written_vregs[32];
+    uint32_t vlen;      /* bits */
+    uint32_t elen;
+
+    const RISCVVectorKernels *vk; /* specialized for vlen, see riscv_cpu_init() */
 
     /* CSRs */
     uint16_t     vstart;
@@ -231,25 +288,29 @@ typedef struct RISCVCPUState {
     target_ulong vl;    /* ro */
 #endif
 
-    uint8_t priv; /* see PRV_x */
-    uint8_t fs;   /* MSTATUS_FS value */
-    uint8_t vs;   /* MSTATUS_VS value */
+    TLBEntry tlb_read[TLB_SIZE];
+    TLBEntry tlb_write[TLB_SIZE];
+    TLBEntry tlb_code[TLB_SIZE];
+#ifndef PADDR_INLINE
+    target_ulong tlb_read_paddr_addend[TLB_SIZE];
+    target_ulong tlb_write_paddr_addend[TLB_SIZE];
+    target_ulong tlb_code_paddr_addend[TLB_SIZE];
+#endif
+
+    /* Cold */
+    PhysMemoryMap *mem_map;
+    int            physical_addr_len;
 
-    uint64_t insn_counter;  // Simulator internal
     uint64_t minstret;      // RISCV CSR (updated when insn_counter increases)
     uint64_t mcycle;        // RISCV CSR (updated when insn_counter increases)
-    BOOL     debug_mode;
     BOOL     stop_the_counter;  // Set in debug mode only (cleared after ending Debug)
 
     BOOL power_down_flag; /* True when the core is idle awaiting
                            * interrupts, does NOT mean terminate
                            * simulation */
-    BOOL         terminate_simulation;
-    int          pending_exception; /* used during MMU exception handling */
-    target_ulong pending_tval;
+    BOOL terminate_simulation;
 
     /* CSRs */
-    target_ulong mstatus;
     target_ulong mtvec;
     target_ulong mscratch;
     target_ulong mepc;
@@ -260,8 +321,6 @@ typedef struct RISCVCPUState {
     target_ulong mimpid;    /* ro */
     target_ulong mhartid;   /* ro */
     uint32_t     misa;
-    uint32_t     mie;
-    uint32_t     mip;
     uint32_t     medeleg;
     uint32_t     mideleg;
     uint32_t     mcounteren;
@@ -270,7 +329,6 @@ typedef struct RISCVCPUState {
 
     target_ulong unimpl_mcontext{0};
 
-    target_ulong tdata1[MAX_TRIGGERS];
     target_ulong tdata2[MAX_TRIGGERS];
 
     target_ulong mhpmevent[32];
@@ -299,37 +357,9 @@ typedef struct RISCVCPUState {
 
     uint32_t plic_enable_irq[2];
 
-    /*
-     * "The SC must fail if a store to the reservation set from
-     * another hart can be observed to occur between the LR and SC."
-     *
-     * To achieve this in a scalable and low-overhead way we maintain
-     * a sequence number for global memory and one per reservation.
-     * As long as the reservation tracks the global number, we know no
-     * other hart has written memory.
-     */
-    target_ulong load_res; /* for atomic LR/SC */
-    uint64_t     load_res_memseqno;
-
-    PhysMemoryMap *mem_map;
-    int            physical_addr_len;
-
-    TLBEntry tlb_read[TLB_SIZE];
-    TLBEntry tlb_write[TLB_SIZE];
-    TLBEntry tlb_code[TLB_SIZE];
-#ifndef PADDR_INLINE
-    target_ulong tlb_read_paddr_addend[TLB_SIZE];
-    target_ulong tlb_write_paddr_addend[TLB_SIZE];
-    target_ulong tlb_code_paddr_addend[TLB_SIZE];
-#endif
-
     // Benchmark return value
     uint64_t benchmark_exit_code;
 
-    /* Control Flow Info */
-    RISCVCTFInfo info;
-    target_ulong next_addr; /* the CFI target address-- only valid for CFIs. */
-
     /* RTC */
     uint64_t timecmp;
 
@@ -364,6 +394,9 @@ typedef struct RISCVCPUState {
 } RISCVCPUState;
 
 RISCVCPUState *riscv_cpu_init(RISCVMachine *machine, int hartid);
+#if VLEN > 0
+bool riscv_vector_config_ok(uint32_t vlen, uint32_t elen);
+#endif
 void           riscv_cpu_end(RISCVCPUState *s);
 int            riscv_cpu_interp(RISCVCPUState *s, int n_cycles);
 uint64_t       riscv_cpu_get_cycles(RISCVCPUState *s);
@@ -392,7 +425,21 @@ void           riscv_get_ctf_target(RISCVCPUState *s, uint64_t *target);
 /* STF Trace Generation */
 void riscv_stf_reset(RISCVCPUState *s);
 
+/* Field offsets, sizes and cache lines of RISCVCPUState */
+void riscv_cpu_print_layout(FILE *f);
+
+/* Access counts per 8 byte word of RISCVCPUState, summed per field by
+ * riscv_cpu_print_layout(). Counted on the register, fetch, TLB and
+ * trigger paths of the interpreter */
+#ifdef CPU_FIELD_STATS
+extern uint64_t cpu_field_hits[];
+#define CPU_FIELD_HIT(s, f) (cpu_field_hits[((uint8_t *)&(s)->f - (uint8_t *)(s)) / 8]++)
+#else
+#define CPU_FIELD_HIT(s, f) ((void)0)
+#endif
+
 int  riscv_cpu_interp64(RISCVCPUState *s, int n_cycles);
+int  riscv_cpu_interp_ffwd64(RISCVCPUState *s, int n_cycles);
 BOOL riscv_terminated(RISCVCPUState *s);
 void riscv_set_debug_mode(RISCVCPUState *s, bool on);
 
@@ -36,6 +36,7 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -86,8 +87,9 @@ struct IsaConfigFlags {
     bool f{DEFAULT_EXT_SETTING};
     bool d{DEFAULT_EXT_SETTING};
     bool c{DEFAULT_EXT_SETTING};
+    bool b{DEFAULT_EXT_SETTING};
 //    bool h{DEFAULT_EXT_SETTING};
-//    bool v{DEFAULT_EXT_SETTING};
+    bool v{DEFAULT_EXT_SETTING};
 
     // Multi-character extensions
     bool zba{DEFAULT_EXT_SETTING};
@@ -114,7 +116,7 @@ struct IsaConfigFlags {
 //    bool zicbop{DEFAULT_EXT_SETTING};
 //    bool zfh{DEFAULT_EXT_SETTING};
 //    bool zfhmin{DEFAULT_EXT_SETTING};
-//    bool zicond{DEFAULT_EXT_SETTING};
+    bool zicond{DEFAULT_EXT_SETTING};
 //    bool zihintntl{DEFAULT_EXT_SETTING};
 //    bool zicntr{DEFAULT_EXT_SETTING};
 //    bool zihpm{DEFAULT_EXT_SETTING};
@@ -172,6 +174,44 @@ private:
 
 extern std::shared_ptr<IsaConfigFlags> isa_flags;
 
+// Extensions the interpreter is specialized on, see majordomo_template.h.
+// The rest of G (and Zicsr, Zifencei) is always there.
+enum : uint32_t {
+  ISA_EXT_C      = 1u << 0,
+  ISA_EXT_V      = 1u << 1,
+  ISA_EXT_ZBA    = 1u << 2,
+  ISA_EXT_ZBB    = 1u << 3,
+  ISA_EXT_ZBC    = 1u << 4,
+  ISA_EXT_ZBS    = 1u << 5,
+  ISA_EXT_ZICOND = 1u << 6,
+};
+
+// The interpreter instances. --march has to name exactly the extensions
+// of one of them, ALL (every implemented extension) runs when there is
+// no --march.
+static constexpr uint32_t ISA_PROFILE_RV64G   = 0;
+static constexpr uint32_t ISA_PROFILE_RV64GB  = ISA_EXT_ZBA | ISA_EXT_ZBB
+                                              | ISA_EXT_ZBS;
+static constexpr uint32_t ISA_PROFILE_RV64GV  = ISA_EXT_V;
+static constexpr uint32_t ISA_PROFILE_RV64GC  = ISA_EXT_C;
+static constexpr uint32_t ISA_PROFILE_RV64GCB = ISA_EXT_C | ISA_PROFILE_RV64GB;
+static constexpr uint32_t ISA_PROFILE_RV64GCV = ISA_EXT_C | ISA_EXT_V;
+static constexpr uint32_t ISA_PROFILE_RVA23   = ISA_PROFILE_RV64GCB
+                                              | ISA_EXT_V | ISA_EXT_ZICOND;
+static constexpr uint32_t ISA_PROFILE_ALL     = ISA_PROFILE_RVA23 | ISA_EXT_ZBC;
+
+struct IsaProfile {
+  const char *name;
+  const char *march; // a --march that selects it
+  uint32_t    ext;
+};
+
+extern const IsaProfile isa_profiles[];
+extern const int        isa_num_profiles;
+
+extern uint32_t isa_config_ext   (const IsaConfigFlags&);
+extern int      isa_profile_index(uint32_t ext);
+
 extern std::unordered_map<std::string, bool IsaConfigFlags::*> extensionMap;
 extern std::unordered_map<char,bool IsaConfigFlags::*> simpleExts;
 
@@ -85,7 +85,8 @@ struct RISCVMachine {
     PhysMemoryMap *   mem_map;
 
 #ifdef LIVECACHE
-    LiveCache *llc;
+    LiveCacheHierarchy *llc;
+    bool                llc_track;  // false outside the warmup window
 #endif
     RISCVCPUState *cpu_state[MAX_CPUS];
 
@@ -133,6 +134,15 @@ struct RISCVMachine {
     /* Clear mimpid, marchid, mvendorid */
     bool clear_ids;
 
+    /* Vector register width and widest element, in bits */
+    uint32_t vlen;
+    uint32_t elen;
+
+    /* ISA_EXT_ bits of --march and the index in isa_profiles[] of the
+       interpreter the harts run */
+    uint32_t isa_ext;
+    int      isa_profile;
+
     /* Extension state, not used by majordomo itself */
     void *ext_state;
 
@@ -68,6 +68,11 @@ typedef enum {
 #define FCLASS_SNAN       (1 << 8)
 #define FCLASS_QNAN       (1 << 9)
 
+/* Use the host FPU for binary32/binary64 arithmetic and binary128 div and
+   sqrt when the result is known to match, see softfp_host.h. Only has an
+   effect in SOFTFP_HOST_FPU builds on SSE2 hosts */
+extern bool softfp_host_fpu;
+
 typedef uint32_t sfloat32;
 typedef uint64_t sfloat64;
 #ifdef HAVE_INT128
@@ -0,0 +1,339 @@
+/*
+ * SoftFP host FPU fast path
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Binary32/binary64 add, mul, fma, div and sqrt on the host SSE unit.
+ *
+ * The host result is used only when it is bit-identical to the softfp
+ * one and the only possible exception is inexact: round to nearest even,
+ * operands and result finite with a biased exponent of at least
+ * 2 * MANT_SIZE + 3.  Everything else (NaNs, infinities,
+ * zeros out of mul/div/sqrt/fma, tiny values, RTZ/RDN/RUP/RMM) returns
+ * false and is done by softfp.
+ *
+ * Inexact comes from an exact error term instead of the MXCSR flags:
+ * TwoSum for add, an FMA residual for mul, div and sqrt, and for fma the
+ * product and the difference r - c split into a rounded value and an
+ * exact error each.  The exponent bound keeps every error term normal, so
+ * FTZ/DAZ in MXCSR (-Ofast) do not matter.  Writing MXCSR to clear the
+ * flags per operation costs more than softfp on many hosts.
+ *
+ * fflags is sticky, so once inexact is set in *pfflags the error term
+ * cannot change it and is not computed.  FP-dense code sets inexact early
+ * and then runs on the bare host operation.
+ *
+ * Only included by softfp.cpp.  Enabled with SOFTFP_HOST_FPU on SSE2
+ * hosts; mul, div, sqrt and fma also need FMA3 at run time.  Binary128
+ * div and sqrt use __float128, see SOFTFP_HOST_FPU_F128 below.
+ */
+#ifndef SOFTFP_HOST_H
+#define SOFTFP_HOST_H
+
+#if defined(SOFTFP_HOST_FPU) && defined(__SSE2__)
+#define SOFTFP_HOST_FPU_SSE
+#include <bit>
+#include <immintrin.h>
+#endif
+
+#ifdef SOFTFP_HOST_FPU_SSE
+
+/* Exceptions masked, round to nearest even. FTZ/DAZ are ignored */
+#define HOST_MXCSR_RNE_MASK 0x7f80
+#define HOST_MXCSR_RNE      0x1f80
+
+/* Keeps the compiler, -Ofast included, from folding the error terms */
+#define HOST_FENCE(v) asm volatile("" : "+x"(v))
+
+template <class F>
+struct host_fmt;
+
+template <>
+struct host_fmt<float> {
+    typedef uint32_t U;
+    static const int mant = 23;
+    static const int emax = 0xff;
+};
+
+template <>
+struct host_fmt<double> {
+    typedef uint64_t U;
+    static const int mant = 52;
+    static const int emax = 0x7ff;
+};
+
+template <class F>
+static inline int host_exp(F x) {
+    typedef host_fmt<F> H;
+    return int((std::bit_cast<typename H::U>(x) >> H::mant) & H::emax);
+}
+
+template <class F>
+static inline bool host_zero(F x) {
+    return (std::bit_cast<typename host_fmt<F>::U>(x) << 1) == 0;
+}
+
+/* Finite and far enough from the subnormal range that the error terms of
+   operations on it are normal */
+template <class F>
+static inline bool host_big(F x) {
+    typedef host_fmt<F> H;
+    int e = host_exp(x);
+    return e >= 2 * H::mant + 3 && e < H::emax;
+}
+
+static inline bool host_rne(RoundingModeEnum rm) {
+    return rm == RM_RNE && (_mm_getcsr() & HOST_MXCSR_RNE_MASK) == HOST_MXCSR_RNE;
+}
+
+/* Inexact already accumulated, the error terms do not matter */
+static inline bool host_nx_set(const uint32_t *pfflags) { return *pfflags & FFLAG_INEXACT; }
+
+template <class F>
+static inline bool host_done(F r, bool inexact, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (inexact)
+        *pfflags |= FFLAG_INEXACT;
+    *pr = std::bit_cast<typename host_fmt<F>::U>(r);
+    return true;
+}
+
+/* s + e == a + b exactly, s = RN(a + b) */
+template <class F>
+static inline F host_two_sum(F a, F b, F *e) {
+    F s = a + b;
+    HOST_FENCE(s);
+    F bb = s - a;
+    HOST_FENCE(bb);
+    F aa = s - bb;
+    HOST_FENCE(aa);
+    F ea = a - aa;
+    HOST_FENCE(ea);
+    F eb = b - bb;
+    HOST_FENCE(eb);
+    *e = ea + eb;
+    return s;
+}
+
+/* Sums of big operands or zeros never underflow, so only the operands are
+   bounded */
+template <class F>
+static inline bool host_add(F a, F b, RoundingModeEnum rm, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (!(host_big(a) || host_zero(a)) || !(host_big(b) || host_zero(b)) || !host_rne(rm))
+        return false;
+
+    F    e  = 0;
+    bool nx = host_nx_set(pfflags);
+    F    s  = nx ? a + b : host_two_sum(a, b, &e);
+    if (host_exp(s) == host_fmt<F>::emax)
+        return false;
+    return host_done(s, !nx && !host_zero(e), pr, pfflags);
+}
+
+static inline bool host_fpu_add(uint32_t a, uint32_t b, RoundingModeEnum rm, uint32_t *pr, uint32_t *pfflags) {
+    return host_add(std::bit_cast<float>(a), std::bit_cast<float>(b), rm, pr, pfflags);
+}
+
+static inline bool host_fpu_add(uint64_t a, uint64_t b, RoundingModeEnum rm, uint64_t *pr, uint32_t *pfflags) {
+    return host_add(std::bit_cast<double>(a), std::bit_cast<double>(b), rm, pr, pfflags);
+}
+
+/* FMA3 is not part of the x86-64 baseline, so the rest is compiled for
+   that target alone and used when the host has it */
+static bool host_has_fma() {
+    static const bool has = (__builtin_cpu_init(), __builtin_cpu_supports("fma"));
+    return has;
+}
+
+#define HOST_FMA __attribute__((target("fma")))
+
+template <class F>
+HOST_FMA static inline F host_fma(F a, F b, F c) {
+    if constexpr (sizeof(F) == 4)
+        return __builtin_fmaf(a, b, c);
+    else
+        return __builtin_fma(a, b, c);
+}
+
+template <class F>
+HOST_FMA static bool host_mul(F a, F b, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (!host_big(a) || !host_big(b))
+        return false;
+
+    F p = a * b;
+    HOST_FENCE(p);
+    if (!host_big(p))
+        return false;
+    if (host_nx_set(pfflags))
+        return host_done(p, false, pr, pfflags);
+    F e = host_fma(a, b, -p);
+    return host_done(p, !host_zero(e), pr, pfflags);
+}
+
+template <class F>
+HOST_FMA static bool host_div(F a, F b, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (!host_big(a) || !host_big(b))
+        return false;
+
+    HOST_FENCE(b); /* no reciprocal under -Ofast */
+    F q = a / b;
+    HOST_FENCE(q);
+    if (!host_big(q))
+        return false;
+    if (host_nx_set(pfflags))
+        return host_done(q, false, pr, pfflags);
+    F e = host_fma(-q, b, a);
+    return host_done(q, !host_zero(e), pr, pfflags);
+}
+
+template <class F>
+HOST_FMA static bool host_sqrt(F a, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (!host_big(a) || std::bit_cast<typename host_fmt<F>::U>(a) >> (sizeof(F) * 8 - 1))
+        return false;
+
+    F r;
+    if constexpr (sizeof(F) == 4)
+        r = _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(a)));
+    else
+        r = _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(a)));
+    HOST_FENCE(r);
+    if (host_nx_set(pfflags))
+        return host_done(r, false, pr, pfflags);
+    F e = host_fma(-r, r, a);
+    return host_done(r, !host_zero(e), pr, pfflags);
+}
+
+/* a * b + c is exact when a * b == r - c. Both sides are split into
+   RN(x) + error, a split that is unique, so they are equal only if both
+   parts are */
+template <class F>
+HOST_FMA static bool host_fmadd(F a, F b, F c, typename host_fmt<F>::U *pr, uint32_t *pfflags) {
+    if (!host_big(a) || !host_big(b) || !(host_big(c) || host_zero(c)))
+        return false;
+
+    F r = host_fma(a, b, c);
+    HOST_FENCE(r);
+    if (!host_big(r))
+        return false;
+    if (host_nx_set(pfflags))
+        return host_done(r, false, pr, pfflags);
+    F p = a * b;
+    HOST_FENCE(p);
+    if (!host_big(p))
+        return false;
+
+    F ep = host_fma(a, b, -p);
+    F ed;
+    F d = host_two_sum(r, -c, &ed);
+    return host_done(r, !(p == d && ep == ed), pr, pfflags);
+}
+
+#define HOST_FPU_OP(name, impl)                                                                   \
+    static inline bool name(uint32_t a, uint32_t b, RoundingModeEnum rm, uint32_t *pr, uint32_t *pfflags) { \
+        return host_has_fma() && host_rne(rm) && impl(std::bit_cast<float>(a), std::bit_cast<float>(b), pr, pfflags); \
+    }                                                                                                  \
+    static inline bool name(uint64_t a, uint64_t b, RoundingModeEnum rm, uint64_t *pr, uint32_t *pfflags) { \
+        return host_has_fma() && host_rne(rm) && impl(std::bit_cast<double>(a), std::bit_cast<double>(b), pr, pfflags); \
+    }
+
+HOST_FPU_OP(host_fpu_mul, host_mul)
+HOST_FPU_OP(host_fpu_div, host_div)
+
+#undef HOST_FPU_OP
+
+static inline bool host_fpu_sqrt(uint32_t a, RoundingModeEnum rm, uint32_t *pr, uint32_t *pfflags) {
+    return host_has_fma() && host_rne(rm) && host_sqrt(std::bit_cast<float>(a), pr, pfflags);
+}
+
+static inline bool host_fpu_sqrt(uint64_t a, RoundingModeEnum rm, uint64_t *pr, uint32_t *pfflags) {
+    return host_has_fma() && host_rne(rm) && host_sqrt(std::bit_cast<double>(a), pr, pfflags);
+}
+
+static inline bool host_fpu_fma(uint32_t a, uint32_t b, uint32_t c, RoundingModeEnum rm, uint32_t *pr, uint32_t *pfflags) {
+    return host_has_fma() && host_rne(rm)
+           && host_fmadd(std::bit_cast<float>(a), std::bit_cast<float>(b), std::bit_cast<float>(c), pr, pfflags);
+}
+
+static inline bool host_fpu_fma(uint64_t a, uint64_t b, uint64_t c, RoundingModeEnum rm, uint64_t *pr, uint32_t *pfflags) {
+    return host_has_fma() && host_rne(rm)
+           && host_fmadd(std::bit_cast<double>(a), std::bit_cast<double>(b), std::bit_cast<double>(c), pr, pfflags);
+}
+
+#undef HOST_FMA
+
+#if defined(HAVE_INT128) && defined(__SIZEOF_FLOAT128__)
+#define SOFTFP_HOST_FPU_F128
+
+/*
+ * Binary128 div and sqrt on __float128.  There is no binary128 unit, the
+ * host operations are the libgcc and libm soft-float routines, correctly
+ * rounded in the MXCSR mode.  They are many times faster than the bit at a
+ * time loops of softfp for 113 bit significands, while softfp add and mul
+ * are as fast as theirs, so those and fma stay in softfp.
+ *
+ * Inexact comes from the odd parts of the significands: a / b is exact
+ * when odd(b) divides odd(a), sqrt(a) when odd(r)^2 == odd(a).
+ */
+template <>
+struct host_fmt<__float128> {
+    typedef uint128_t U;
+    static const int mant = 112;
+    static const int emax = 0x7fff;
+};
+
+/* The significand of a big value, trailing zeros dropped */
+static inline uint128_t host_odd_mant(__float128 x) {
+    uint128_t m  = (std::bit_cast<uint128_t>(x) & (((uint128_t)1 << 112) - 1)) | (uint128_t)1 << 112;
+    uint64_t  lo = (uint64_t)m;
+    return m >> (lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll((uint64_t)(m >> 64)));
+}
+
+static bool host_div128(__float128 a, __float128 b, uint128_t *pr, uint32_t *pfflags) {
+    if (!host_big(a) || !host_big(b))
+        return false;
+
+    __float128 q = a / b;
+    if (!host_big(q))
+        return false;
+    if (host_nx_set(pfflags))
+        return host_done(q, false, pr, pfflags);
+    return host_done(q, host_odd_mant(a) % host_odd_mant(b) != 0, pr, pfflags);
+}
+
+static bool host_sqrt128(__float128 a, uint128_t *pr, uint32_t *pfflags) {
+    if (!host_big(a) || std::bit_cast<uint128_t>(a) >> 127)
+        return false;
+
+    __float128 r = __builtin_sqrtf128(a);
+    if (host_nx_set(pfflags))
+        return host_done(r, false, pr, pfflags);
+
+    /* wider than 57 bits the square does not fit in 113 */
+    uint128_t o     = host_odd_mant(r);
+    bool      exact = (o >> 57) == 0 && o * o == host_odd_mant(a);
+    return host_done(r, !exact, pr, pfflags);
+}
+
+static inline bool host_fpu_div(uint128_t a, uint128_t b, RoundingModeEnum rm, uint128_t *pr, uint32_t *pfflags) {
+    return host_rne(rm) && host_div128(std::bit_cast<__float128>(a), std::bit_cast<__float128>(b), pr, pfflags);
+}
+
+static inline bool host_fpu_sqrt(uint128_t a, RoundingModeEnum rm, uint128_t *pr, uint32_t *pfflags) {
+    return host_rne(rm) && host_sqrt128(std::bit_cast<__float128>(a), pr, pfflags);
+}
+#endif /* HAVE_INT128 && __SIZEOF_FLOAT128__ */
+
+#endif /* SOFTFP_HOST_FPU_SSE */
+
+#endif /* SOFTFP_HOST_H */
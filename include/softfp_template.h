@@ -228,6 +228,13 @@ BOOL isnan_sf(F_UINT a) {
 }
 
 F_UINT add_sf(F_UINT a, F_UINT b, RoundingModeEnum rm, uint32_t *pfflags) {
+#if F_SIZE <= 64 && defined(SOFTFP_HOST_FPU_SSE)
+    {
+        F_UINT r;
+        if (softfp_host_fpu && host_fpu_add(a, b, rm, &r, pfflags))
+            return r;
+    }
+#endif
     uint32_t a_sign, b_sign, a_exp, b_exp;
     F_UINT   tmp, a_mant, b_mant;
 
@@ -336,6 +343,13 @@ static F_UINT mul_u(F_UINT *plow, F_UINT a, F_UINT b) {
 #endif
 
 F_UINT mul_sf(F_UINT a, F_UINT b, RoundingModeEnum rm, uint32_t *pfflags) {
+#if F_SIZE <= 64 && defined(SOFTFP_HOST_FPU_SSE)
+    {
+        F_UINT r;
+        if (softfp_host_fpu && host_fpu_mul(a, b, rm, &r, pfflags))
+            return r;
+    }
+#endif
     uint32_t a_sign, b_sign, r_sign;
     int32_t  a_exp, b_exp, r_exp;
     F_UINT   a_mant, b_mant, r_mant, r_mant_low;
@@ -386,6 +400,13 @@ F_UINT mul_sf(F_UINT a, F_UINT b, RoundingModeEnum rm, uint32_t *pfflags) {
 
 /* fused multiply and add */
 F_UINT fma_sf(F_UINT a, F_UINT b, F_UINT c, RoundingModeEnum rm, uint32_t *pfflags) {
+#if F_SIZE <= 64 && defined(SOFTFP_HOST_FPU_SSE)
+    {
+        F_UINT r;
+        if (softfp_host_fpu && host_fpu_fma(a, b, c, rm, &r, pfflags))
+            return r;
+    }
+#endif
     uint32_t a_sign, b_sign, c_sign, r_sign;
     int32_t  a_exp, b_exp, c_exp, r_exp, shift;
     F_UINT   a_mant, b_mant, c_mant, r_mant1, r_mant0, c_mant1, c_mant0, mask;
@@ -590,6 +611,13 @@ static F_UINT divrem_u(F_UINT *pr, F_UINT a1, F_UINT a0, F_UINT b) {
 #endif
 
 F_UINT div_sf(F_UINT a, F_UINT b, RoundingModeEnum rm, uint32_t *pfflags) {
+#if (F_SIZE <= 64 && defined(SOFTFP_HOST_FPU_SSE)) || (F_SIZE == 128 && defined(SOFTFP_HOST_FPU_F128))
+    {
+        F_UINT r;
+        if (softfp_host_fpu && host_fpu_div(a, b, rm, &r, pfflags))
+            return r;
+    }
+#endif
     uint32_t a_sign, b_sign, r_sign;
     int32_t  a_exp, b_exp, r_exp;
     F_UINT   a_mant, b_mant, r_mant, r;
@@ -717,6 +745,13 @@ static int sqrtrem_u(F_UINT *pr, F_UINT a1, F_UINT a0) {
 #endif
 
 F_UINT sqrt_sf(F_UINT a, RoundingModeEnum rm, uint32_t *pfflags) {
+#if (F_SIZE <= 64 && defined(SOFTFP_HOST_FPU_SSE)) || (F_SIZE == 128 && defined(SOFTFP_HOST_FPU_F128))
+    {
+        F_UINT r;
+        if (softfp_host_fpu && host_fpu_sqrt(a, rm, &r, pfflags))
+            return r;
+    }
+#endif
     uint32_t a_sign;
     int32_t  a_exp;
     F_UINT   a_mant;
@@ -0,0 +1,170 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Whole register group kernels for the vector integer ops.
+ *
+ * A register group is contiguous in the register file, so an op over
+ * elements [start, end) of vd is one loop over flat arrays, with the
+ * narrow sources of widening ops as arrays of half width elements.
+ * The loop body is a host vector of VG_BYTES bytes: AVX2 when the build
+ * targets it, SSE2 otherwise, and plain element code on other hosts and
+ * for the unaligned head and the tail. Masked kernels blend the result
+ * with the old vd under the v0 bits of the elements.
+ *
+ * The kernel is picked once per instruction from SEW, vv/vx and vm.
+ * Results are the same as the element loop as long as vd does not
+ * overlap a source in a different place, vectorize_arithmetic checks that.
+ */
+#ifndef VECTOR_GROUP_H
+#define VECTOR_GROUP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define VG_BYTES 32
+#elif defined(__SSE2__)
+#define VG_BYTES 16
+#else
+#define VG_BYTES 0
+#endif
+
+/* vd, vs2 and vs1 point to element 0 of the groups, vs1 is NULL for .vx
+ * and .vi, x the scalar. v0 is NULL when unmasked */
+typedef void (*Vector_Group_Op)(uint8_t *vd, const uint8_t *vs2, const uint8_t *vs1, uint64_t x, const uint8_t *v0,
+                                unsigned start, unsigned end);
+
+template <bool SIGNED, int W>
+using vg_elm_t = std::conditional_t<
+    W == 8, std::conditional_t<SIGNED, int8_t, uint8_t>,
+    std::conditional_t<W == 16, std::conditional_t<SIGNED, int16_t, uint16_t>,
+                       std::conditional_t<W == 32, std::conditional_t<SIGNED, int32_t, uint32_t>,
+                                          std::conditional_t<SIGNED, int64_t, uint64_t>>>>;
+
+static inline bool vg_mask_bit(const uint8_t *v0, unsigned e) { return v0[e / 8] >> e % 8 & 1; }
+
+/* One element of vd = vs2 + vs1, the sources extended to the vd width */
+template <class D, class S2, class S1, bool VV, bool MASKED>
+static inline void vg_add_elm(uint8_t *vd, const uint8_t *vs2, const uint8_t *vs1, uint64_t x, const uint8_t *v0, unsigned e) {
+    typedef std::make_unsigned_t<D> U;
+
+    if (MASKED && !vg_mask_bit(v0, e))
+        return;
+
+    S2 a;
+    S1 b = S1(x);
+    memcpy(&a, vs2 + e * sizeof(S2), sizeof(a));
+    if (VV)
+        memcpy(&b, vs1 + e * sizeof(S1), sizeof(b));
+    U r = U(D(a)) + U(D(b));
+    memcpy(vd + e * sizeof(D), &r, sizeof(r));
+}
+
+#if VG_BYTES
+template <class T, unsigned K>
+struct vg_vec {
+    typedef T t __attribute__((vector_size(K * sizeof(T))));
+};
+
+/* All ones in the lanes of the K elements from e whose v0 bit is set, e a
+ * multiple of K */
+template <class U, unsigned K>
+static inline typename vg_vec<U, K>::t vg_mask_lanes(const uint8_t *v0, unsigned e) {
+    typedef typename vg_vec<U, K>::t UV;
+
+    UV m, bit;
+    if constexpr (sizeof(U) == 1) {
+        UV bytes = {}, sel;
+        memcpy(&bytes, v0 + e / 8, K / 8);
+        for (unsigned l = 0; l < K; ++l) {
+            sel[l] = l / 8;
+            bit[l] = U(1) << l % 8;
+        }
+        m = __builtin_shuffle(bytes, sel);
+    } else {
+        uint64_t w = 0;
+        memcpy(&w, v0 + e / 8, (K + 7) / 8);
+        w >>= e % 8;
+        m = UV{} + U(w);
+        for (unsigned l = 0; l < K; ++l) bit[l] = U(1) << l;
+    }
+    return (UV)((m & bit) != 0);
+}
+#endif
+
+template <class D, class S2, class S1, bool VV, bool MASKED>
+static void vg_add(uint8_t *vd, const uint8_t *vs2, const uint8_t *vs1, uint64_t x, const uint8_t *v0, unsigned e,
+                   unsigned end) {
+#if VG_BYTES
+    typedef std::make_unsigned_t<D> U;
+    const unsigned K = VG_BYTES / sizeof(D);
+    typedef typename vg_vec<U, K>::t  UV;
+    typedef typename vg_vec<D, K>::t  DV;
+    typedef typename vg_vec<S2, K>::t S2V;
+    typedef typename vg_vec<S1, K>::t S1V;
+
+    for (; e < end && e % K; ++e) vg_add_elm<D, S2, S1, VV, MASKED>(vd, vs2, vs1, x, v0, e);
+
+    UV b = UV{} + U(D(S1(x)));
+    for (; e + K <= end; e += K) {
+        S2V a2;
+        memcpy(&a2, vs2 + e * sizeof(S2), sizeof(a2));
+        if (VV) {
+            S1V b1;
+            memcpy(&b1, vs1 + e * sizeof(S1), sizeof(b1));
+            b = (UV)__builtin_convertvector(b1, DV);
+        }
+        UV r = (UV)__builtin_convertvector(a2, DV) + b;
+        if (MASKED) {
+            UV old, m = vg_mask_lanes<U, K>(v0, e);
+            memcpy(&old, vd + e * sizeof(D), sizeof(old));
+            r = (r & m) | (old & ~m);
+        }
+        memcpy(vd + e * sizeof(D), &r, sizeof(r));
+    }
+#endif
+    for (; e < end; ++e) vg_add_elm<D, S2, S1, VV, MASKED>(vd, vs2, vs1, x, v0, e);
+}
+
+template <bool SIGNED, int D_MUL, int S2_MUL, int SEW>
+static inline Vector_Group_Op vg_add_pick(bool vv, bool vm) {
+    if constexpr (SEW * D_MUL > 64)
+        return NULL;
+    else {
+        typedef vg_elm_t<SIGNED, SEW * D_MUL>  D;
+        typedef vg_elm_t<SIGNED, SEW * S2_MUL> S2;
+        typedef vg_elm_t<SIGNED, SEW>          S1;
+        if (vv)
+            return vm ? &vg_add<D, S2, S1, true, false> : &vg_add<D, S2, S1, true, true>;
+        return vm ? &vg_add<D, S2, S1, false, false> : &vg_add<D, S2, S1, false, true>;
+    }
+}
+
+/* vd = vs2 + vs1 with vd D_MUL and vs2 S2_MUL times SEW wide, vs1 SEW
+ * wide. SIGNED picks sign or zero extension of the narrow sources */
+template <bool SIGNED, int D_MUL, int S2_MUL>
+static inline Vector_Group_Op vg_add_config(uint8_t sew, bool vv, bool vm) {
+    switch (sew) {
+        case 8: return vg_add_pick<SIGNED, D_MUL, S2_MUL, 8>(vv, vm);
+        case 16: return vg_add_pick<SIGNED, D_MUL, S2_MUL, 16>(vv, vm);
+        case 32: return vg_add_pick<SIGNED, D_MUL, S2_MUL, 32>(vv, vm);
+        case 64: return vg_add_pick<SIGNED, D_MUL, S2_MUL, 64>(vv, vm);
+        default: return NULL;
+    }
+}
+
+#endif /* VECTOR_GROUP_H */
@@ -18,7 +18,7 @@
 #define LMUL_MASK     7
 #define LMUL_BOUNDARY (1 << 2)
 
-#define VSTART_MASK (VLEN - 1)
+#define VSTART_MASK(s) ((s)->vlen - 1)
 #define VXSAT_MASK  (1 << 0)
 #define VXRM_MASK   (3 << 0)
 #define VCSR_VXSAT  VXSAT_MASK
@@ -31,10 +31,20 @@ enum width_config { SINGLE_WIDTH, WIDEN_VD_VS2, WIDEN_VD, WIDEN_VS2 };
 
 /* Definitions of "vectorizable" functions, which are expected to perform many times.
  * Each corresponds to one or more vector instruction categories (OPIVV, OPFVV, etc..) */
-typedef target_ulong (*Vector_Reg_Access)(RISCVCPUState *, uint8_t, uint8_t);
+typedef target_ulong (*Vector_Reg_Access)(RISCVCPUState *, uint8_t, unsigned);
 typedef bool (*Vector_Memory_Op)(RISCVCPUState *, target_ulong, uint8_t *);
 typedef void (*Vector_Integer_Op)(RISCVCPUState *, uint8_t *, uint8_t *, void *);
 
+/* Instruction level loops, one set per common VLEN with the width known
+ * at compile time and one that reads it from the hart. Picked once when
+ * the hart is created */
+struct RISCVVectorKernels {
+    uint32_t vlen; /* 0 for any */
+    int (*mem_op)(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op (*vmem_op_config)(uint8_t));
+    bool (*arithmetic)(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulong vs1, uint8_t width_config, bool vv, bool vm,
+                       Vector_Integer_Op (*v_op_config)(uint8_t));
+};
+
 /* Templates for declaration of what will return the relevant "vectorizable" function.
  * Can be thought of as the 'element width config' function. One
  * exists for every vector insn. */
@@ -97,11 +107,11 @@ typedef void (*Vector_Integer_Op)(RISCVCPUState *, uint8_t *, uint8_t *, void *)
     }
 
 /* v_reg_read */
-#define V_REG_READ(WIDTH)                                                                 \
-    static target_ulong v_reg_read_e##WIDTH(RISCVCPUState *s, uint8_t reg, uint8_t elm) { \
-        uint8_t *        ptr = &s->v_reg[reg][elm * (WIDTH >> 3)];                        \
-        uint##WIDTH##_t *val = (uint##WIDTH##_t *)ptr;                                    \
-        return *val;                                                                      \
+#define V_REG_READ(WIDTH)                                                                  \
+    static target_ulong v_reg_read_e##WIDTH(RISCVCPUState *s, uint8_t reg, unsigned elm) { \
+        uint8_t *        ptr = &s->v_reg[reg][elm * (WIDTH >> 3)];                         \
+        uint##WIDTH##_t *val = (uint##WIDTH##_t *)ptr;                                     \
+        return *val;                                                                       \
     }
 // V_REG_ACCESS_CONFIG(v_reg_read, V_REG_READ)
 
@@ -139,7 +149,7 @@ V_OP_CONFIG(v_add, V_ADD)
         uint##WIDTH##_t * val   = (uint##WIDTH##_t *)val_ptr;                                  \
         uint##WIDTH##_t * vs2_e = (uint##WIDTH##_t *)vs2;                                      \
         uint##WIDTH2##_t *vd_e  = (uint##WIDTH2##_t *)vd;                                      \
-        *vd_e                   = *vs2_e + *val;                                               \
+        *vd_e                   = (uint##WIDTH2##_t)*vs2_e + *val;                             \
     }
 V_WIDEN_OP_CONFIG(vw_addu, VW_ADDU)
 
@@ -159,7 +169,7 @@ V_WIDEN_OP_CONFIG(vw_adduw, VW_ADDUW)
         int##WIDTH##_t * val   = (int##WIDTH##_t *)val_ptr;                                   \
         int##WIDTH##_t * vs2_e = (int##WIDTH##_t *)vs2;                                       \
         int##WIDTH2##_t *vd_e  = (int##WIDTH2##_t *)vd;                                       \
-        *vd_e                  = *vs2_e + *val;                                               \
+        *vd_e                  = (int##WIDTH2##_t)*vs2_e + *val;                              \
     }
 V_WIDEN_OP_CONFIG(vw_add, VW_ADD)
 
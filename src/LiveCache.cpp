@@ -50,27 +50,46 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "LiveCacheCore.h"
+#include "json.h"
+#include "machine.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
 
 //#define MTRACE(a...)   do{ fprintf(stderr,"@%lld %s %d 0x%x:",(long long int)globalClock,getName(), (int)mreq->getID(), (unsigned
 // int)mreq->getAddr()); fprintf(stderr,##a); fprintf(stderr,"\n"); }while(0)
 #define MTRACE(a...)
 
-LiveCache::LiveCache(const std::string &_name, int size, uint64_t _mem_base, uint64_t _mem_size) : name(_name) {
-    cacheBank    = CacheType::create(size, 16, 64, "LRU", false);
-    lineSize     = cacheBank->getLineSize();
-    lineSizeBits = log2i(lineSize);
-    mem_base     = _mem_base;
-    mem_end      = _mem_base + _mem_size;
+LiveCache::LiveCache(const LiveCacheLevelConfig &_cfg, uint64_t _mem_base) : cfg(_cfg), mem_base(_mem_base) {
+    if (strcasecmp(cfg.policy.c_str(), k_RANDOM) == 0)
+        policy = RANDOM;
+    else if (strcasecmp(cfg.policy.c_str(), k_LRUp) == 0)
+        policy = LRUp;
+    else
+        policy = LRU;
+
+    assoc        = cfg.assoc;
+    numSets      = (uint32_t)(cfg.size / cfg.line_size / cfg.assoc);
+    setMask      = numSets - 1;
+    lineSizeBits = log2i(cfg.line_size);
+
+    stampOffset  = (sizeof(uint32_t) * assoc + 7) & ~(uint64_t)7;
+    storesOffset = stampOffset + sizeof(uint64_t) * assoc;
+    setBytes     = (uint32_t)((storesOffset + sizeof(uint64_t) + 63) & ~(uint64_t)63);
+
+    sets = (uint8_t *)aligned_alloc(64, (uint64_t)setBytes * numSets);
+    assert(sets);
+    memset(sets, 0, (uint64_t)setBytes * numSets);
 
     nReadHit   = 0;
     nReadMiss  = 0;
     nWriteHit  = 0;
     nWriteMiss = 0;
 
-    assert(getLineSize() < 4096);  // To avoid bank selection conflict (insane LiveCache line)
-
-    lineCount = (uint64_t)cacheBank->getNumLines();
-    maxOrder  = 0;
+    maxOrder = 0;
+    lastIdx  = ~(uint64_t)0;
+    rnd      = 0x9e3779b97f4a7c15ULL;
 }
 
 LiveCache::~LiveCache() {
@@ -82,7 +101,7 @@ LiveCache::~LiveCache() {
 
     fprintf(stderr,
             "%s nReadHit:%lld nReadMiss:%lld nReadMissRate:%3.1f%% nWriteHit:%lld nWriteMiss:%lld nWriteMissRate:%3.1f%%\n",
-            name.c_str(),
+            cfg.name.c_str(),
             nReadHit,
             nReadMiss,
             100.0 * ((double)nReadMiss) / (nReadHit + nReadMiss),
@@ -90,113 +109,428 @@ LiveCache::~LiveCache() {
             nWriteMiss,
             100.0 * ((double)nWriteMiss) / (nWriteHit + nWriteMiss));
 
-    cacheBank->destroy();
+    free(sets);
 }
 
-void LiveCache::read(uint64_t addr) {
-    if (addr<mem_base || addr>mem_end)
-      return; // only track between mem_base and mem_end
+// Order 0 marks a line that was never filled, stamps start at 1
+bool LiveCache::fill(uint64_t addr, bool st, uint64_t &victim, bool &victim_st) {
+    uint64_t  idx    = lineIdx(addr);
+    uint32_t  set    = idx & setMask;
+    uint32_t *tags   = tagsOf(set);
+    uint64_t *stamps = stampsOf(set);
+    uint64_t &stores = storesOf(set);
 
-    Line *l = cacheBank->findLine(addr);
-    if (l) {
-        l->order = maxOrder++;
-        nReadHit++;
-        return;
+    int way = findWay(tags, (uint32_t)idx + 1, assoc);
+    if (way < 0)
+        way = findWay(tags, 0, assoc);
+
+    if (way < 0) {
+        if (policy == RANDOM) {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 7;
+            rnd ^= rnd << 17;
+            way = (int)(rnd & (assoc - 1));
+        } else {
+            way = 0;
+            for (uint32_t i = 1; i < assoc; i++)
+                if (stamps[i] < stamps[way])
+                    way = i;
+        }
     }
-    nReadMiss++;
 
-    l        = cacheBank->fillLine(addr);
-    l->st    = false;
-    l->order = maxOrder++;
+    bool evicted = tags[way] && tags[way] != (uint32_t)idx + 1;
+    if (evicted) {
+        victim    = lineAddr(tags[way]);
+        victim_st = (stores >> way) & 1;
+    }
+
+    tags[way] = (uint32_t)idx + 1;
+    stores    = (stores & ~(1ULL << way)) | ((uint64_t)st << way);
+
+    // LRUp inserts at the LRU position, only a hit promotes the line
+    if (policy == LRUp && evicted) {
+        lastIdx = ~(uint64_t)0;
+    } else {
+        stamps[way] = ++maxOrder;
+        lastIdx     = idx;
+    }
+
+    return evicted;
 }
 
-void LiveCache::write(uint64_t addr) {
-    if (addr<mem_base || addr>mem_end)
-      return; // only track between mem_base and mem_end
+bool LiveCache::invalidate(uint64_t addr, bool &was_st) {
+    uint64_t idx = lineIdx(addr);
+    uint32_t set = idx & setMask;
+    int      way = findWay(tagsOf(set), (uint32_t)idx + 1, assoc);
+    if (way < 0)
+        return false;
+
+    was_st             = (storesOf(set) >> way) & 1;
+    tagsOf(set)[way]   = 0;
+    stampsOf(set)[way] = 0;
+    storesOf(set) &= ~(1ULL << way);
+    if (idx == lastIdx)
+        lastIdx = ~(uint64_t)0;
+    return true;
+}
 
-    Line *l = cacheBank->findLine(addr);
-    if (l) {
-        l->order = maxOrder++;
-        l->st    = true;
+bool LiveCache::markStore(uint64_t addr) {
+    uint64_t idx = lineIdx(addr);
+    uint32_t set = idx & setMask;
+    int      way = findWay(tagsOf(set), (uint32_t)idx + 1, assoc);
+    if (way < 0)
+        return false;
 
-        nWriteHit++;
-        return;
+    storesOf(set) |= 1ULL << way;
+    return true;
+}
+
+void LiveCache::traverse(std::vector<uint64_t> &lines) const {
+    // Gather the resident lines with their stamps
+    std::vector<Entry> arr;
+    arr.reserve((uint64_t)numSets * assoc);
+
+    uint64_t minOrder = UINT64_MAX;
+    for (uint32_t set = 0; set < numSets; set++) {
+        uint32_t *tags   = tagsOf(set);
+        uint64_t *stamps = stampsOf(set);
+        uint64_t  stores = storesOf(set);
+        for (uint32_t way = 0; way < assoc; way++) {
+            if (!tags[way])
+                continue;
+            arr.push_back({stamps[way], lineAddr(tags[way]) | ((stores >> way) & 1)});
+            minOrder = std::min(minOrder, stamps[way]);
+        }
     }
-    nWriteMiss++;
 
-    l        = cacheBank->fillLine(addr);
-    l->st    = true;
-    l->order = maxOrder++;
+    radixSort(arr, minOrder);
+
+    lines.resize(arr.size());
+    for (uint64_t i = 0; i < arr.size(); i++) lines[i] = arr[i].addr;
 }
 
-uint64_t *LiveCache::traverse(uint64_t &n_entries) {
-    // Creating an array of cache lines
-    Line *   arr[lineCount];
-    uint64_t cnt = 0;
-    for (uint64_t i = 0; i < lineCount; i++) {
-        if (cacheBank->getPLine(i) && cacheBank->getPLine(i)->order) {
-            arr[cnt] = cacheBank->getPLine(i);
-            cnt++;
+// LSD radix sort on the stamps, rebased to minOrder so only the digits
+// that span the live stamps are sorted. Stable and linear in the number of
+// resident lines, the scratch buffer is on the heap.
+void LiveCache::radixSort(std::vector<Entry> &arr, uint64_t minOrder) {
+    const int      bits  = 11;
+    const uint64_t radix = 1ULL << bits;
+
+    if (arr.size() < 2)
+        return;
+
+    uint64_t span = 0;
+    for (Entry &e : arr) {
+        e.order -= minOrder;
+        span |= e.order;
+    }
+
+    std::vector<Entry>    tmp(arr.size());
+    std::vector<uint64_t> count(radix);
+    for (int shift = 0; shift < 64 && (span >> shift); shift += bits) {
+        std::fill(count.begin(), count.end(), 0);
+        for (const Entry &e : arr) count[(e.order >> shift) & (radix - 1)]++;
+
+        uint64_t pos = 0;
+        for (uint64_t d = 0; d < radix; d++) {
+            uint64_t c = count[d];
+            count[d]   = pos;
+            pos += c;
         }
+
+        for (const Entry &e : arr) tmp[count[(e.order >> shift) & (radix - 1)]++] = e;
+        arr.swap(tmp);
     }
-    mergeSort(arr, cnt);
+}
 
-    uint64_t *addrs = (uint64_t *)malloc(sizeof(uint64_t) * cnt);
+/*********************************************************
+ *  LiveCacheHierarchy
+ *********************************************************/
 
-    // creating loads and stores arrays
-    uint64_t in = 0;
-    for (uint64_t i = 0; i < cnt; i++) {
-        if (!arr[i]->getTag())
-            continue;
-        if (arr[i]->st) {
-            addrs[in] = 1 | (uint64_t)cacheBank->calcAddr4Tag(arr[i]->getTag());
-        } else {
-            addrs[in] = (uint64_t)cacheBank->calcAddr4Tag(arr[i]->getTag());
-            assert((addrs[in] & 1) == 0);
+LiveCacheHierarchy::LiveCacheHierarchy(const std::vector<LiveCacheLevelConfig> &cfgs, uint64_t _mem_base,
+                                       uint64_t _mem_size) {
+    mem_base = _mem_base;
+    mem_end  = _mem_base + _mem_size;
+
+    for (size_t i = 0; i < cfgs.size(); i++) {
+        // Tags are 32 bit line indexes
+        if ((_mem_size / cfgs[i].line_size) >= UINT32_MAX) {
+            fprintf(majordomo_stderr, "live cache: %s: too many %d B lines in RAM\n", cfgs[i].name.c_str(), cfgs[i].line_size);
+            exit(-1);
         }
-        in++;
+        levels.push_back(new LiveCache(cfgs[i], _mem_base));
+        if (cfgs[i].side != LC_DATA)
+            ipath.push_back((int)i);
+        if (cfgs[i].side != LC_INST)
+            dpath.push_back((int)i);
     }
+}
+
+LiveCacheHierarchy::~LiveCacheHierarchy() {
+    for (LiveCache *l : levels) delete l;
+}
 
-    n_entries = in;
+void LiveCacheHierarchy::miss(const std::vector<int> &path, uint64_t addr, bool st) {
+    // Probe the outer levels as reads, a store only marks the level
+    // closest to the core
+    size_t hit = 1;
+    while (hit < path.size() && !levels[path[hit]]->access(addr, false)) hit++;
 
-    return addrs;
+    // An exclusive level hands the line up
+    bool fill_st = st;
+    if (hit < path.size() && levels[path[hit]]->getConfig().inclusion == LC_EXCLUSIVE) {
+        bool was_st = false;
+        levels[path[hit]]->invalidate(addr, was_st);
+        fill_st |= was_st;
+    }
+
+    // Fill the missing levels outermost first, the store bit only lands
+    // in the level closest to the core, write back from there on
+    for (size_t pos = hit; pos-- > 0;) {
+        if (pos && levels[path[pos]]->getConfig().inclusion == LC_EXCLUSIVE)
+            continue;
+        insert(path, pos, addr, pos == 0 ? fill_st : false);
+    }
 }
 
-void LiveCache::mergeSort(Line **arr, uint64_t len) {
-    // in case we had one element
-    if (len < 2)
+void LiveCacheHierarchy::insert(const std::vector<int> &path, size_t pos, uint64_t addr, bool st) {
+    LiveCache *c = levels[path[pos]];
+
+    uint64_t victim    = 0;
+    bool     victim_st = false;
+    if (!c->fill(addr, st, victim, victim_st))
         return;
 
-    // in case we had two elements
-    if (len == 2) {
-        if (arr[0]->order > arr[1]->order) {
-            // swap
-            Line *t = arr[0];
-            arr[0]  = arr[1];
-            arr[1]  = t;
+    // Back-invalidate every level above an inclusive one, on either side
+    if (pos && c->getConfig().inclusion == LC_INCLUSIVE) {
+        for (int i = 0; i < path[pos]; i++) {
+            bool was_st = false;
+            if (levels[i]->invalidate(victim, was_st))
+                victim_st |= was_st;
         }
+    }
+
+    if (pos + 1 >= path.size())
         return;
+
+    // An exclusive level below takes the victim, otherwise a dirty victim
+    // is written back, allocating if the level below does not have it
+    LiveCache *next = levels[path[pos + 1]];
+    if (next->getConfig().inclusion == LC_EXCLUSIVE)
+        insert(path, pos + 1, victim, victim_st);
+    else if (victim_st && !next->markStore(victim))
+        insert(path, pos + 1, victim, true);
+}
+
+void LiveCacheHierarchy::exportWarmup(std::vector<WarmupLevel> &warm) const {
+    warm.clear();
+    for (LiveCache *l : levels) {
+        const LiveCacheLevelConfig &c = l->getConfig();
+
+        WarmupLevel w;
+        w.name      = c.name;
+        w.policy    = c.policy;
+        w.size      = c.size;
+        w.assoc     = c.assoc;
+        w.line_size = c.line_size;
+        w.side      = (uint8_t)c.side;
+        w.inclusion = (uint8_t)c.inclusion;
+
+        l->traverse(w.lines);
+
+        warm.push_back(std::move(w));
     }
+}
 
-    // divide and conquer
-    uint64_t mid = (uint64_t)(len / 2);
-    Line *   arr1[mid];
-    Line *   arr2[len - mid];
-    for (uint64_t i = 0; i < mid; i++) arr1[i] = arr[i];
-    for (uint64_t i = 0; i < len - mid; i++) arr2[i] = arr[mid + i];
-    mergeSort(arr1, mid);
-    mergeSort(arr2, len - mid);
-
-    // merging
-    uint64_t m = 0;
-    uint64_t n = 0;
-    for (uint64_t i = 0; i < len; i++) {
-        if (n >= (len - mid) || (m < mid && arr1[m]->order <= arr2[n]->order)) {
-            arr[i] = arr1[m];
-            m++;
-        } else {
-            arr[i] = arr2[n];
-            n++;
+void LiveCacheHierarchy::preload(const std::vector<WarmupLevel> &warm) {
+    for (const WarmupLevel &w : warm) {
+        LiveCache *l = 0;
+        for (LiveCache *c : levels)
+            if (c->getName() == w.name)
+                l = c;
+
+        if (!l) {
+            fprintf(majordomo_stderr, "-W: warmup level %s is not in the live cache, skipped\n", w.name.c_str());
+            continue;
         }
+        if (l->getConfig().size != w.size || (uint32_t)l->getConfig().assoc != w.assoc
+            || (uint32_t)l->getConfig().line_size != w.line_size)
+            fprintf(majordomo_stderr, "-W: warmup level %s geometry differs from the live cache\n", w.name.c_str());
+
+        uint64_t victim;
+        bool     victim_st;
+        for (uint64_t a : w.lines)
+            if (a >= mem_base && a < mem_end)
+                l->fill(a & ~(uint64_t)1, a & 1, victim, victim_st);
+    }
+}
+
+bool LiveCacheHierarchy::dump(const char *dump_name) const {
+    std::vector<WarmupLevel> warm;
+    exportWarmup(warm);
+
+    std::string name = std::string(dump_name) + ".warmup";
+    return warmup_write(name.c_str(), warm);
+}
+
+/*********************************************************
+ *  Config
+ *********************************************************/
+
+std::vector<LiveCacheLevelConfig> livecache_default_config(uint64_t size) {
+    LiveCacheLevelConfig c;
+    c.name = "LiveCache";
+    c.size = size;
+    return std::vector<LiveCacheLevelConfig>(1, c);
+}
+
+// Sizes are integers or strings with an optional K, M or G suffix
+static bool livecache_get_size(JSONValue obj, const char *name, uint64_t *pval) {
+    JSONValue val = json_object_get(obj, name);
+
+    if (json_is_undefined(val))
+        return true;
+
+    if (val.type == JSON_INT) {
+        *pval = (uint64_t)val.u.int64;
+        return true;
     }
+
+    if (val.type == JSON_STR) {
+        char *   end;
+        uint64_t v = strtoull(val.u.str->data, &end, 0);
+        switch (*end) {
+            case 'k':
+            case 'K': v <<= 10; end++; break;
+            case 'm':
+            case 'M': v <<= 20; end++; break;
+            case 'g':
+            case 'G': v <<= 30; end++; break;
+        }
+        if (end != val.u.str->data && *end == 0) {
+            *pval = v;
+            return true;
+        }
+    }
+
+    fprintf(majordomo_stderr, "live cache: %s: size expected\n", name);
+    return false;
+}
+
+static bool livecache_get_str(JSONValue obj, const char *name, std::string &str) {
+    JSONValue val = json_object_get(obj, name);
+
+    if (json_is_undefined(val))
+        return true;
+
+    if (val.type != JSON_STR) {
+        fprintf(majordomo_stderr, "live cache: %s: string expected\n", name);
+        return false;
+    }
+
+    str = val.u.str->data;
+    return true;
+}
+
+static bool livecache_pow2(uint64_t v) { return v && (v & (v - 1)) == 0; }
+
+static bool livecache_parse_level(JSONValue obj, size_t idx, LiveCacheLevelConfig &c) {
+    uint64_t    assoc = c.assoc, line_size = c.line_size;
+    std::string side = "unified", inclusion = "inclusive";
+
+    c.name = "L" + std::to_string(idx + 1);
+
+    if (obj.type != JSON_OBJ) {
+        fprintf(majordomo_stderr, "live cache: level %zu: object expected\n", idx);
+        return false;
+    }
+
+    if (!livecache_get_str(obj, "name", c.name) || !livecache_get_size(obj, "size", &c.size)
+        || !livecache_get_size(obj, "assoc", &assoc) || !livecache_get_size(obj, "line_size", &line_size)
+        || !livecache_get_str(obj, "policy", c.policy) || !livecache_get_str(obj, "side", side)
+        || !livecache_get_str(obj, "inclusion", inclusion))
+        return false;
+
+    c.assoc     = (int32_t)assoc;
+    c.line_size = (int32_t)line_size;
+
+    if (!livecache_pow2(c.size) || !livecache_pow2(assoc) || !livecache_pow2(line_size) || line_size >= 4096
+        || assoc > 64 || c.size < assoc * line_size * 2) {
+        fprintf(majordomo_stderr,
+                "live cache: %s: size, assoc (at most 64) and line_size must be powers of two with at least two sets\n",
+                c.name.c_str());
+        return false;
+    }
+
+    if (strcasecmp(c.policy.c_str(), k_LRU) && strcasecmp(c.policy.c_str(), k_LRUp)
+        && strcasecmp(c.policy.c_str(), k_RANDOM)) {
+        fprintf(majordomo_stderr, "live cache: %s: policy must be LRU, LRUp or RANDOM\n", c.name.c_str());
+        return false;
+    }
+
+    if (side == "unified")
+        c.side = LC_UNIFIED;
+    else if (side == "inst")
+        c.side = LC_INST;
+    else if (side == "data")
+        c.side = LC_DATA;
+    else {
+        fprintf(majordomo_stderr, "live cache: %s: side must be unified, inst or data\n", c.name.c_str());
+        return false;
+    }
+
+    if (inclusion == "inclusive")
+        c.inclusion = LC_INCLUSIVE;
+    else if (inclusion == "exclusive")
+        c.inclusion = LC_EXCLUSIVE;
+    else if (inclusion == "nine")
+        c.inclusion = LC_NINE;
+    else {
+        fprintf(majordomo_stderr, "live cache: %s: inclusion must be inclusive, exclusive or nine\n", c.name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool livecache_load_config(const char *filename, std::vector<LiveCacheLevelConfig> &cfgs) {
+    uint8_t *buf;
+    int      len = load_file(&buf, filename);
+
+    JSONValue cfg = json_parse_value_len((const char *)buf, len);
+    free(buf);
+    if (json_is_error(cfg)) {
+        fprintf(majordomo_stderr, "%s: %s\n", filename, json_get_error(cfg));
+        json_free(cfg);
+        return false;
+    }
+
+    bool      ok  = true;
+    JSONValue arr = json_object_get(cfg, "levels");
+    if (arr.type != JSON_ARRAY || arr.u.array->len == 0) {
+        fprintf(majordomo_stderr, "%s: expecting a non empty 'levels' array\n", filename);
+        ok = false;
+    }
+
+    cfgs.clear();
+    for (int i = 0; ok && i < (int)arr.u.array->len; i++) {
+        LiveCacheLevelConfig c;
+        ok = livecache_parse_level(json_array_get(arr, i), cfgs.size(), c);
+        cfgs.push_back(c);
+    }
+
+    // The first level on each side has nothing above it to be exclusive of
+    bool seen_inst = false, seen_data = false;
+    for (size_t i = 0; ok && i < cfgs.size(); i++) {
+        bool first = (cfgs[i].side != LC_DATA && !seen_inst) || (cfgs[i].side != LC_INST && !seen_data);
+        if (first && cfgs[i].inclusion == LC_EXCLUSIVE) {
+            fprintf(majordomo_stderr, "%s: %s: the first level cannot be exclusive\n", filename, cfgs[i].name.c_str());
+            ok = false;
+        }
+        seen_inst |= cfgs[i].side != LC_DATA;
+        seen_data |= cfgs[i].side != LC_INST;
+    }
+
+    json_free(cfg);
+    return ok;
 }
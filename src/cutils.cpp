@@ -46,6 +46,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/time.h>
 
 void *mallocz(size_t size) {
@@ -119,3 +120,28 @@ void dbuf_free(DynBuf *s) {
     free(s->buf);
     memset(s, 0, sizeof *s);
 }
+
+/* Peak resident set size of this process image in KiB. VmHWM is reset
+   by exec, unlike ru_maxrss which also covers the parent's pre-exec image. */
+long get_peak_rss_kib(void) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[128];
+        long kib = -1;
+        while (fgets(line, sizeof line, f)) {
+            if (sscanf(line, "VmHWM: %ld", &kib) == 1)
+                break;
+        }
+        fclose(f);
+        if (kib >= 0)
+            return kib;
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+}
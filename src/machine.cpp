@@ -337,10 +337,15 @@ static int virt_machine_parse_config(VirtMachineParams *p, char *config_file_str
 
     vm_get_uint64_opt(cfg, "physical_addr_len", &p->physical_addr_len);
 
+    vm_get_uint64_opt(cfg, "vlen", &p->vlen);
+    vm_get_uint64_opt(cfg, "elen", &p->elen);
+
     if (vm_get_str_opt(cfg, "logfile", &p->logfile) < 0)
         goto tag_fail;
     if (vm_get_str_opt(cfg, "bootrom", &p->bootrom_name) < 0)
         goto tag_fail;
+    if (vm_get_str_opt(cfg, "live_cache_config", &p->live_cache_config) < 0)
+        goto tag_fail;
 
     json_free(cfg);
     return 0;
@@ -528,4 +533,5 @@ void virt_machine_free_config(VirtMachineParams *p) {
     free(p->input_device);
     free(p->display_device);
     free(p->cfg_filename);
+    free(p->live_cache_config);
 }
@@ -31,10 +31,14 @@
 #include "majordomo_cosim.h"
 #endif
 
+#include "majordomo_simpoint.h"
 #include "majordomo_stf.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <signal.h>
+#include <sys/resource.h>
+#include <string>
 #include <unordered_map>
 
 using namespace std;
@@ -52,21 +56,94 @@ std::shared_ptr<IsaConfigFlags> isa_flags(IsaConfigFlags::getInstance());
 FILE *simpoint_bb_file = nullptr;
 int   simpoint_roi     = 0;  // start without ROI enabled
 
-int simpoint_step(RISCVMachine *m, int hartid) {
+// simpoint_step state, reset between the bbv and checkpoint passes
+struct SimpointState {
+    uint64_t                               ninst          = 0;  // insts in BB, or since ROI start
+    uint64_t                               interval_ninst = 0;  // insts in the current interval
+    uint64_t                               last_pc        = 0;
+    std::unordered_map<uint64_t, uint64_t> bbv;
+    std::unordered_map<uint64_t, int>      pc2id;
+    int                                    next_id        = 1;
+    std::vector<SimpointBbv>               intervals;           // kept for --simpoint_cluster
+};
+
+static SimpointState simpoint_state;
+
+static void simpoint_dump_interval(RISCVMachine *m) {
+    SimpointState &st = simpoint_state;
+    if (st.bbv.empty()) return;
+
+    SimpointBbv interval;
+    fprintf(simpoint_bb_file, "T");
+    for (const auto &ent : st.bbv) {
+        auto it = st.pc2id.find(ent.first);
+        int  id = 0;
+        if (it == st.pc2id.end()) {
+            id                  = st.next_id++;
+            st.pc2id[ent.first] = id;
+        } else {
+            id = it->second;
+        }
+
+        fprintf(simpoint_bb_file, ":%d:%" PRIu64 " ", id, ent.second);
+        if (m->common.simpoint_cluster) interval.bb.push_back({(uint32_t)id, ent.second});
+    }
+    fprintf(simpoint_bb_file, "\n");
+    fflush(simpoint_bb_file);
+    st.bbv.clear();
+
+    if (m->common.simpoint_cluster) st.intervals.push_back(std::move(interval));
+}
+
+// Number of instructions to run before the next simpoint_step call. BBV
+// collection needs every basic block boundary, checkpointing only needs to
+// land exactly on the next simpoint start.
+static int simpoint_cycles_request(RISCVMachine *m, int n_cycles) {
+    if (simpoint_bb_file) return 1;
+
+    const auto &sp = m->common.simpoints[m->common.simpoint_next];
+    if (sp.start <= simpoint_state.ninst) return 1;
+    return (int)std::min<uint64_t>(n_cycles, sp.start - simpoint_state.ninst);
+}
+
+// Checkpoint pass: run the fast-forward engine up to the next simpoint
+// start, iterate_core hands back to the full engine when it gets there or
+// when tracing needs the observers. A LIVECACHE build already skips the
+// observers outside the warmup window and must track inside it.
+static void simpoint_ffwd_request(RISCVMachine *m, int n_cycles) {
+#ifndef LIVECACHE
+    if (simpoint_bb_file || m->common.simpoint_next >= m->common.simpoints.size())
+        return;
+    if (m->common.exe_trace < (unsigned)n_cycles || m->common.interactive || m->common.stf_macro_tracing_active
+        || m->common.stf_insn_tracing_active)
+        return;
+
+    uint64_t start = m->common.simpoints[m->common.simpoint_next].start;
+    if (start <= simpoint_state.ninst)
+        return;
+    m->common.ffwd_until_insns = m->common.num_executed + (start - simpoint_state.ninst);
+    m->common.ffwd             = true;
+#else
+    (void)m;
+    (void)n_cycles;
+#endif
+}
+
+int simpoint_step(RISCVMachine *m, int hartid, int n_insns) {
     assert(hartid == 0);  // Only single core for simpoint creation
 
-    static uint64_t ninst = 0;  // ninst in BB
-    ninst++;
+    SimpointState &st = simpoint_state;
+    st.ninst += n_insns;
 
     if (simpoint_bb_file == 0) {  // Creating checkpoints mode
 
         assert(!m->common.simpoints.empty());
 
         auto &sp = m->common.simpoints[m->common.simpoint_next];
-        if (ninst > sp.start) {
+        if (st.ninst >= sp.start) {
             char str[100];
             sprintf(str, "sp%d", sp.id);
-            virt_machine_serialize(m, str);
+            virt_machine_serialize_async(m, str);
 
             m->common.simpoint_next++;
             if (m->common.simpoint_next == m->common.simpoints.size()) {
@@ -79,50 +156,76 @@ int simpoint_step(RISCVMachine *m, int hartid) {
     // Creating bb trace mode
     assert(m->common.simpoints.empty());
 
-    uint64_t                                 pc            = virt_machine_get_pc(m, hartid);
-    static uint64_t                          next_bbv_dump = UINT64_MAX;
-    static std::unordered_map<uint64_t, int> bbv;
-    static std::unordered_map<uint64_t, int> pc2id;
-    static int                               next_id = 1;
-    if (m->common.maxinsns <= next_bbv_dump) {
-        if (m->common.maxinsns > m->common.simpoint_size)
-            next_bbv_dump = m->common.maxinsns - m->common.simpoint_size;
-        else
-            next_bbv_dump = 0;
-
-        if (bbv.size()) {
-            fprintf(simpoint_bb_file, "T");
-            for (const auto ent : bbv) {
-                auto it = pc2id.find(ent.first);
-                int  id = 0;
-                if (it == pc2id.end()) {
-                    id = next_id;
-                    next_id++;
-                    pc2id[ent.first] = next_id;
-                } else {
-                    id = it->second;
-                }
-
-                fprintf(simpoint_bb_file, ":%d:%d ", id, ent.second);
-            }
-            fprintf(simpoint_bb_file, "\n");
-            fflush(simpoint_bb_file);
-            bbv.clear();
-        }
+    uint64_t pc = virt_machine_get_pc(m, hartid);
+
+    st.interval_ninst += n_insns;
+    if (st.interval_ninst >= m->common.simpoint_size) {
+        simpoint_dump_interval(m);
+        st.interval_ninst = 0;
     }
 
-    static uint64_t last_pc = 0;
-    if ((last_pc + 2) != pc && (last_pc + 4) != pc) {
-        bbv[last_pc] += ninst;
-        // fprintf(simpoint_bb_file,"xxxBB 0x%" PRIx64 " %d\n", pc, ninst);
-        ninst = 0;
+    if ((st.last_pc + 2) != pc && (st.last_pc + 4) != pc) {
+        st.bbv[st.last_pc] += st.ninst;
+        st.ninst = 0;
     }
-    last_pc = pc;
+    st.last_pc = pc;
 
     return 1;
 }
 
-static std::tuple<int, int> iterate_core(RISCVMachine *m, int hartid, int n_cycles) {
+// Cluster the collected intervals and write the simpoints/weights files
+static std::vector<SimpointPick> simpoint_select(RISCVMachine *m) {
+    SimpointClusterParams params;
+    params.max_k       = m->common.simpoint_maxk;
+    params.dim         = m->common.simpoint_dim;
+    params.num_threads = m->common.simpoint_threads;
+
+    auto picks = simpoint_cluster(simpoint_state.intervals, params);
+    if (picks.empty()) {
+        fprintf(majordomo_stderr, "simpoint: no bbv intervals collected, "
+                "check --simpoint_size and the ROI markers\n");
+        return picks;
+    }
+
+    std::string prefix    = m->common.simpoint_out ? m->common.simpoint_out : "majordomo_simpoint";
+    std::string sp_name   = prefix + ".simpoints";
+    std::string wt_name   = prefix + ".weights";
+    if (!simpoint_write(picks, sp_name.c_str(), wt_name.c_str())) picks.clear();
+    else fprintf(majordomo_stderr, "simpoint: wrote %s and %s\n", sp_name.c_str(), wt_name.c_str());
+
+    return picks;
+}
+
+static void ffwd_stop(RISCVMachine *m, int hartid) {
+    m->common.ffwd = false;
+    fprintf(majordomo_stderr, "-I: fast-forward done at %" PRIu64 " instructions, pc 0x%" PRIx64 "\n",
+            m->common.num_executed, virt_machine_get_pc(m, hartid));
+}
+
+// -------------------------------------------------------------------------
+// End of run statistics. Instruction counts are the ones returned by the
+// interpreter, wall time is charged to the mode iterate_core ran in.
+// -------------------------------------------------------------------------
+enum RunMode { RUN_EXECUTE, RUN_FFWD, RUN_TRACE, RUN_IDLE, RUN_NUM_MODES };
+
+static const char *run_mode_name[RUN_NUM_MODES] = {"execute", "fast_forward", "trace", "idle"};
+
+struct RunStats {
+    uint64_t insns[MAX_CPUS]              = {};  // retired, per hart
+    uint64_t mode_insns[RUN_NUM_MODES]    = {};
+    double   mode_seconds[RUN_NUM_MODES]  = {};
+    double   start                        = 0;   // wall clock
+};
+
+static RunStats run_stats;
+
+static uint64_t run_stats_total_insns() {
+    uint64_t n = 0;
+    for (uint64_t i : run_stats.insns) n += i;
+    return n;
+}
+
+static std::tuple<int, int, RunMode> iterate_core(RISCVMachine *m, int hartid, int n_cycles) {
 
     RISCVCPUState *cpu = m->cpu_state[hartid];
 
@@ -134,7 +237,7 @@ static std::tuple<int, int> iterate_core(RISCVMachine *m, int hartid, int n_cycl
     uint32_t insn_raw = -1;
     bool     en_trace       = false; //This is log or console tracing not STF
     bool     in_interactive = false;
-    (void) in_interactive;
+    bool     idle           = riscv_cpu_get_power_down(cpu);
 
     (void)riscv_read_insn(cpu, &insn_raw, last_pc);
 
@@ -146,29 +249,70 @@ static std::tuple<int, int> iterate_core(RISCVMachine *m, int hartid, int n_cycl
         n_cycles = 1;
     }
 
+    // Fast-forward: hand over to the instrumented engine at the requested
+    // instruction count, or as soon as something needs the observers
+    if (m->common.ffwd) {
+        uint64_t left = m->common.ffwd_until_insns ? m->common.ffwd_until_insns - m->common.num_executed
+                                                   : UINT64_MAX;
+        if (m->common.ffwd_until_insns <= m->common.num_executed && m->common.ffwd_until_insns
+            || m->common.exe_trace < (unsigned) n_cycles || m->common.interactive
+            || m->common.stf_macro_tracing_active || m->common.stf_insn_tracing_active
+            || last_pc == m->common.ffwd_until_pc) {
+            ffwd_stop(m, hartid);
+        } else if (left < (uint64_t)n_cycles) {
+            n_cycles = left;
+        }
+    }
+
     if (m->common.exe_trace < (unsigned) n_cycles) {
         n_cycles = 1;
         en_trace = true;
     } else if(m->common.interactive) {
         n_cycles = 1;
         in_interactive = true;
-    } else {
-        m->common.exe_trace -= n_cycles;
     }
 
-    m->common.num_executed = m->common.num_executed + n_cycles;
+    RunMode mode = idle              ? RUN_IDLE
+                 : m->common.ffwd    ? RUN_FFWD
+                 : en_trace || in_interactive || n_cycles == 1 && simpoint_bb_file
+                   || m->common.stf_macro_tracing_active || m->common.stf_insn_tracing_active
+                                     ? RUN_TRACE
+                                     : RUN_EXECUTE;
 
-    if(m->common.maxinsns  < uint64_t(n_cycles)) {
-        m->common.maxinsns = 0;
-    } else {
-        m->common.maxinsns -= n_cycles;
-    }
+#ifdef LIVECACHE
+    // Outside the warmup window nothing is tracked, nothing else needs
+    // the observers either unless tracing
+    m->common.live_cache_ffwd = !m->llc_track && mode == RUN_EXECUTE;
+    if (m->common.live_cache_ffwd)
+        mode = RUN_FFWD;
+#endif
 
-    if (m->common.maxinsns <= 0)
+    if (m->common.maxinsns == 0)
         /* Succeed after N instructions without failure. */
-        return {0, 0};
+        return {0, 0, mode};
+
+    if (m->common.maxinsns < uint64_t(n_cycles))
+        n_cycles = m->common.maxinsns;
 
-    int keep_going = virt_machine_run(m, hartid, n_cycles);
+    int n_executed = 0;
+    int keep_going = virt_machine_run(m, hartid, n_cycles, &n_executed);
+
+    // Charge what the interpreter retired. A hart that retires nothing
+    // (e.g. trapping on every fetch) still uses up one unit of maxinsns
+    // so the run is guaranteed to end.
+    m->common.num_executed += n_executed;
+    run_stats.insns[hartid] += n_executed;
+
+    uint64_t charge = std::max(n_executed, 1);
+    m->common.maxinsns = m->common.maxinsns < charge ? 0 : m->common.maxinsns - charge;
+    if (m->common.maxinsns == 0)
+        keep_going = 0;
+
+    if (!en_trace && !in_interactive)
+        m->common.exe_trace -= std::min<uint64_t>(n_executed, m->common.exe_trace);
+
+    if (m->common.ffwd && virt_machine_get_pc(m, hartid) == m->common.ffwd_until_pc)
+        ffwd_stop(m, hartid);
 
     // STF: Trace the insn if tracing is active. Do not trace start or stop opcodes.
     if (m->common.stf_macro_tracing_active && !m->common.stf_is_start_opc && !m->common.stf_is_stop_opc ||
@@ -177,22 +321,163 @@ static std::tuple<int, int> iterate_core(RISCVMachine *m, int hartid, int n_cycl
         stf_trace_element(m,hartid,priv,last_pc,insn_raw);
     }
 
-    if (!en_trace && !in_interactive) {
-        return {keep_going, n_cycles};
+    if(en_trace) { execution_trace(m,hartid,insn_raw); }
+
+    return {keep_going, n_executed, mode};
+}
+
+#ifdef LIVECACHE
+// Warmup window: with --live_cache_window n only the last n instructions
+// before a checkpoint are tracked. Returns n_cycles clamped to the start of
+// the window. The distance is known for simpoint checkpoints and for
+// --save with --maxinsns, anything else is tracked from reset.
+static int live_cache_window_request(RISCVMachine *m, bool en_simpoint, int n_cycles) {
+    uint64_t window = m->common.live_cache_window;
+    uint64_t left   = UINT64_MAX;
+
+    if (window == 0) {
+        m->llc_track = true;
+        return n_cycles;
+    }
+
+    if (en_simpoint && !simpoint_bb_file && m->common.simpoint_next < m->common.simpoints.size()) {
+        uint64_t start = m->common.simpoints[m->common.simpoint_next].start;
+        left = start > simpoint_state.ninst ? start - simpoint_state.ninst : 0;
+    } else if (m->common.snapshot_save_name && m->common.maxinsns != UINT64_MAX) {
+        left = m->common.maxinsns;
     }
 
-    if(en_trace) { execution_trace(m,hartid,insn_raw); }
+    m->llc_track = left <= window;
+    if (!m->llc_track)
+        n_cycles = (int)std::min<uint64_t>(n_cycles, left - window);
+    return n_cycles;
+}
+#endif
+
+// Run until the machine stops, returns the instruction count
+static uint64_t run_machine(RISCVMachine *m) {
+
+    RISCVCPUState *cpu = m->cpu_state[0];
+
+    int n_cycles_request = 10000;
+
+    uint64_t prev_prog_asid = 0;
+    uint64_t inst_heart_beat = 0;
+    uint64_t total_inst_count = 0;
+    int keep_going = 0;
+    int n_cycles_actual = 0;
+    do {
+        prev_prog_asid = (cpu->satp);
+
+        bool en_simpoint = simpoint_roi && m->common.simpoint_en_bbv;
+        int  n_cycles    = en_simpoint ? simpoint_cycles_request(m, n_cycles_request)
+                                       : n_cycles_request;
+#ifdef LIVECACHE
+        n_cycles = live_cache_window_request(m, en_simpoint, n_cycles);
+#endif
+        if (en_simpoint)
+            simpoint_ffwd_request(m, n_cycles);
+
+        keep_going = 0;
+        n_cycles_actual = 0;
+        for (int i = 0; i < m->ncpus; ++i) {
+            double t0 = get_current_time_in_seconds();
+            const auto [keep_going_retval, n_cycles_actual_retval, mode] = iterate_core(m, i, n_cycles);
+            run_stats.mode_seconds[mode] += get_current_time_in_seconds() - t0;
+            run_stats.mode_insns[mode]   += n_cycles_actual_retval;
+            keep_going |= keep_going_retval;
+            n_cycles_actual += n_cycles_actual_retval;
+        }
+
+        inst_heart_beat += n_cycles_actual;
+        total_inst_count += n_cycles_actual;
+        if(inst_heart_beat > m->common.heartbeat){
+            fprintf(majordomo_stderr, "HeartBeat : %li / %li \n", inst_heart_beat, total_inst_count);
+            inst_heart_beat = 0;
+        }
+
+        if((cpu->satp) != prev_prog_asid){
+            fprintf(majordomo_stderr, "\n\t -- ASID ::  %lx --> %lx @%li \n",
+                    prev_prog_asid, (cpu->satp), total_inst_count);
+        }
+
+        if (en_simpoint) {
+            if (!simpoint_step(m, 0, n_cycles_actual)) break;
+        }
+
+    } while (keep_going && !m->common.stf_has_exit_pending);
 
-    return {keep_going, n_cycles};
+    return total_inst_count;
 }
 
-static double execution_start_ts;
-static uint64_t *execution_progress_meassure;
+static double mips(uint64_t insns, double seconds) {
+    return seconds > 0.0 ? 1e-6 * insns / seconds : 0.0;
+}
+
+// Console summary, and the --stats_file JSON when requested
+static void run_stats_report(RISCVMachine *m) {
+    double wall = get_current_time_in_seconds() - run_stats.start;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    double user = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6;
+    double sys  = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+    long   rss  = get_peak_rss_kib();
+
+    uint64_t total = run_stats_total_insns();
+
+    fprintf(majordomo_stderr, "-I: instruction Count: %li \n", total);
+    if (m->ncpus > 1) {
+        for (int i = 0; i < m->ncpus; ++i)
+            fprintf(majordomo_stderr, "-I:   hart %d: %" PRIu64 " instructions, %5.2f MIPS\n",
+                    i, run_stats.insns[i], mips(run_stats.insns[i], wall));
+    }
+    fprintf(majordomo_stderr, "-I: simulation speed: %5.2f MIPS (%d hart%s)\n",
+            mips(total, wall), m->ncpus, m->ncpus > 1 ? "s" : "");
+    fprintf(majordomo_stderr, "-I: host time: %.3fs wall, %.3fs user, %.3fs sys, %ld KiB peak rss\n",
+            wall, user, sys, rss);
+    for (int i = 0; i < RUN_NUM_MODES; ++i) {
+        if (run_stats.mode_insns[i] == 0 && run_stats.mode_seconds[i] == 0.0) continue;
+        fprintf(majordomo_stderr, "-I:   %-12s %.3fs, %" PRIu64 " instructions, %5.2f MIPS\n",
+                run_mode_name[i], run_stats.mode_seconds[i], run_stats.mode_insns[i],
+                mips(run_stats.mode_insns[i], run_stats.mode_seconds[i]));
+    }
+    if (m->common.cpu_layout)
+        riscv_cpu_print_layout(majordomo_stderr);
+
+    if (!m->common.stats_file) return;
+
+    FILE *f = fopen(m->common.stats_file, "w");
+    if (!f) {
+        fprintf(majordomo_stderr, "could not open stats file %s\n", m->common.stats_file);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"instructions\": %" PRIu64 ",\n", total);
+    fprintf(f, "  \"mips\": %.3f,\n", mips(total, wall));
+    fprintf(f, "  \"wall_seconds\": %.6f,\n", wall);
+    fprintf(f, "  \"user_seconds\": %.6f,\n", user);
+    fprintf(f, "  \"sys_seconds\": %.6f,\n", sys);
+    fprintf(f, "  \"peak_rss_kib\": %ld,\n", rss);
+    fprintf(f, "  \"harts\": [");
+    for (int i = 0; i < m->ncpus; ++i)
+        fprintf(f, "%s\n    {\"hart\": %d, \"instructions\": %" PRIu64 ", \"mips\": %.3f}",
+                i ? "," : "", i, run_stats.insns[i], mips(run_stats.insns[i], wall));
+    fprintf(f, "\n  ],\n");
+    fprintf(f, "  \"modes\": {");
+    for (int i = 0; i < RUN_NUM_MODES; ++i)
+        fprintf(f, "%s\n    \"%s\": {\"seconds\": %.6f, \"instructions\": %" PRIu64 ", \"mips\": %.3f}",
+                i ? "," : "", run_mode_name[i], run_stats.mode_seconds[i], run_stats.mode_insns[i],
+                mips(run_stats.mode_insns[i], run_stats.mode_seconds[i]));
+    fprintf(f, "\n  }\n}\n");
+    fclose(f);
+}
 
 static void sigintr_handler(int dummy) {
     double t = get_current_time_in_seconds();
-    fprintf(majordomo_stderr, "Simulation speed: %5.2f MIPS (single-core)\n",
-            1e-6 * *execution_progress_meassure / (t - execution_start_ts));
+    fprintf(majordomo_stderr, "Simulation speed: %5.2f MIPS\n",
+            mips(run_stats_total_insns(), t - run_stats.start));
     exit(1);
 }
 
@@ -210,6 +495,8 @@ int main(int argc, char **argv) {
 
     RISCVMachine *m = virt_machine_main(argc, argv);
 
+    if (!m) return 1;
+
     if (m->common.simpoints.empty() && m->common.simpoint_en_bbv) {
         if (m->common.simpoint_bb_file != nullptr){
              simpoint_bb_file = fopen(m->common.simpoint_bb_file, "w");
@@ -224,48 +511,42 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (!m) return 1;
-
-    RISCVCPUState *cpu = m->cpu_state[0];
+    if (m->common.simpoint_roi_at_reset) simpoint_roi = 1;
 
-    int n_cycles_request = 10000;
-    execution_start_ts = get_current_time_in_seconds();
-    execution_progress_meassure = &m->cpu_state[0]->minstret;
+    run_stats.start = get_current_time_in_seconds();
     signal(SIGINT, sigintr_handler);
 
-    uint64_t prev_prog_asid = 0;
-    uint64_t inst_heart_beat = 0;
-    uint64_t total_inst_count = 0;
-    int keep_going = 0;
-    int n_cycles_actual = 0;
-    do {
-        prev_prog_asid = (cpu->satp);
+    uint64_t total_inst_count = run_machine(m);
 
-        keep_going = 0;
-        n_cycles_actual = 0;
-        for (int i = 0; i < m->ncpus; ++i) {
-            const auto [keep_going_retval, n_cycles_actual_retval] = iterate_core(m, i, n_cycles_request);
-            keep_going |= keep_going_retval;
-            n_cycles_actual += n_cycles_actual_retval;
-        }
+    if (m->common.simpoint_cluster) {
+        auto picks = simpoint_select(m);
 
-        inst_heart_beat += n_cycles_actual;
-        total_inst_count += n_cycles_actual;
-        if(inst_heart_beat > m->common.heartbeat){
-            fprintf(majordomo_stderr, "HeartBeat : %li / %li \n", inst_heart_beat, total_inst_count);
-            inst_heart_beat = 0;
-        }
+        if (m->common.simpoint_auto) {
+            if (picks.empty()) return 1;
 
-        if((cpu->satp) != prev_prog_asid){
-            fprintf(majordomo_stderr, "\n\t -- ASID ::  %lx --> %lx @%li \n",
-                    prev_prog_asid, (cpu->satp), total_inst_count);
-        }
+            // Second pass: fast-forward a fresh machine and checkpoint
+            // each selected interval
+            fclose(simpoint_bb_file);
+            simpoint_bb_file = nullptr;
 
-        if (simpoint_roi && m->common.simpoint_en_bbv) {
-            if (!simpoint_step(m, 0)) break;
+            virt_machine_end(m);
+            m = virt_machine_main(argc, argv);
+            if (!m) return 1;
+
+            for (const auto &p : picks) simpoint_add(&m->common, p.interval, p.id);
+            std::sort(m->common.simpoints.begin(), m->common.simpoints.end());
+            m->common.simpoint_next = 0;
+
+            simpoint_state = SimpointState();
+            simpoint_roi   = m->common.simpoint_roi_at_reset;
+
+            fprintf(majordomo_stderr, "simpoint: checkpoint pass, %zu simpoints\n",
+                    m->common.simpoints.size());
+            total_inst_count = run_machine(m);
         }
+    }
 
-    } while (keep_going && !m->common.stf_has_exit_pending);
+    RISCVCPUState *cpu = m->cpu_state[0];
 
     FILE *asid_file = fopen("benchmark_asid", "w");
     fprintf(asid_file, "%lx", cpu->satp);
@@ -275,7 +556,7 @@ int main(int argc, char **argv) {
     fprintf(total_insn_count_file, "%lx", total_inst_count);
     fflush(total_insn_count_file);
 
-    double t = get_current_time_in_seconds();
+    run_stats_report(m);
 
     for (int i = 0; i < m->ncpus; ++i) {
         int benchmark_exit_code = riscv_benchmark_exit_code(m->cpu_state[i]);
@@ -293,26 +574,10 @@ int main(int argc, char **argv) {
     //    stf_trace_close();
     //}
 
-    fprintf(majordomo_stderr, "-I: instruction Count: %li \n", total_inst_count);
-    fprintf(majordomo_stderr, "-I: simulation speed: %5.2f MIPS (single-core)\n",
-            1e-6 * *execution_progress_meassure / (t - execution_start_ts));
     fprintf(majordomo_stderr, "-I: power off.\n");
 
     virt_machine_end(m);
 #endif
 
-#ifdef LIVECACHE
-#if 0
-    // LiveCache Dump
-    uint64_t addr_size;
-    uint64_t *addr = m->llc->traverse(addr_size);
-
-    for (uint64_t i = 0u; i < addr_size; ++i) {
-        printf("addr:%llx %s\n", (unsigned long long)addr[i], (addr[i] & 1) ? "ST" : "LD");
-    }
-#endif
-    delete m->llc;
-#endif
-
     return 0;
 }
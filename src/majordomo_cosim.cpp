@@ -22,6 +22,10 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "cutils.h"
 #include "majordomo.h"
 #include "iomem.h"
@@ -36,6 +40,25 @@ void check_inorder_init(int ncores);
 
 int simpoint_roi = 0;
 
+/*
+ * One entry of the decoupled checking queue, see
+ * majordomo_cosim_async_start().  Traps and memory overrides travel in
+ * the same queue as the commits so they apply in DUT order.
+ */
+struct CosimAsyncEntry {
+    enum Kind : uint8_t { COMMIT, TRAP, MEM } kind;
+    bool     check;
+    int8_t   size_log2;
+    int      hartid;
+    uint32_t insn;
+    uint64_t addr;     // commit pc, override paddr
+    uint64_t data;     // commit wdata, override value, trap cause
+    uint64_t mstatus;
+};
+
+static int  cosim_async_push(RISCVMachine *r, const CosimAsyncEntry &e);
+static void cosim_async_stop(RISCVMachine *r);
+
 /*
  * majordomo_cosim_init --
  *
@@ -56,7 +79,10 @@ majordomo_cosim_state_t *majordomo_cosim_init(int argc, char *argv[]) {
     return (majordomo_cosim_state_t *)m;
 }
 
-void majordomo_cosim_fini(majordomo_cosim_state_t *state) { virt_machine_end((RISCVMachine *)state); }
+void majordomo_cosim_fini(majordomo_cosim_state_t *state) {
+    cosim_async_stop((RISCVMachine *)state);
+    virt_machine_end((RISCVMachine *)state);
+}
 
 static bool is_store_conditional(uint32_t insn) {
     int opcode = insn & 0x7f, funct3 = insn >> 12 & 7;
@@ -165,9 +191,7 @@ static inline void handle_dut_overrides(RISCVCPUState *s, int priv, uint64_t pc,
  * MSB indicates an asynchronous interrupt, synchronous exception
  * otherwise.
  */
-void majordomo_cosim_raise_trap(majordomo_cosim_state_t *state, int hartid, int64_t cause) {
-    VirtMachine *m = (VirtMachine *)state;
-
+static void cosim_raise_trap(VirtMachine *m, int hartid, int64_t cause) {
     if (cause < 0) {
         assert(m->pending_interrupt == -1);
         m->pending_interrupt = cause & 63;
@@ -178,6 +202,21 @@ void majordomo_cosim_raise_trap(majordomo_cosim_state_t *state, int hartid, int6
     }
 }
 
+void majordomo_cosim_raise_trap(majordomo_cosim_state_t *state, int hartid, int64_t cause) {
+    RISCVMachine *r = (RISCVMachine *)state;
+
+    if (r->common.cosim_async) {
+        CosimAsyncEntry e = {};
+        e.kind   = CosimAsyncEntry::TRAP;
+        e.hartid = hartid;
+        e.data   = (uint64_t)cause;
+        cosim_async_push(r, e);
+        return;
+    }
+
+    cosim_raise_trap(&r->common, hartid, cause);
+}
+
 /*
  * majordomo_cosim_step --
  *
@@ -193,21 +232,15 @@ void majordomo_cosim_raise_trap(majordomo_cosim_state_t *state, int hartid, int6
  * time, and instret.  For all these cases the model will override
  * with the expected values.
  */
-int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t dut_pc, uint32_t dut_insn, uint64_t dut_wdata,
-                       uint64_t dut_mstatus, bool check) {
-    RISCVMachine *r = (RISCVMachine *)state;
-    assert(r->ncpus > hartid);
-    RISCVCPUState *s = r->cpu_state[hartid];
-    VirtMachine    m = r->common;
+static inline int cosim_step(RISCVMachine *r, RISCVCPUState *s, int hartid, uint64_t dut_pc, uint32_t dut_insn,
+                             uint64_t dut_wdata, uint64_t dut_mstatus, bool check) {
+    VirtMachine   &m = r->common;
     uint64_t       emu_pc, emu_wdata = 0;
     int            emu_priv;
     uint32_t       emu_insn;
     bool           emu_wrote_data = false;
     int            exit_code      = 0;
-    bool           verbose        = true;
     int            iregno, fregno;
-    char           log_buffer[512];
-    int            log_buff_space;
 
     /* Succeed after N instructions without failure. */
     if (r->common.maxinsns == 0) {
@@ -260,11 +293,8 @@ int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t du
                 /* Unfortunately, handling the error case is awkward,
                  * so we just exit from here */
 
-                log_buff_space = snprintf(log_buffer, 512, "%d 0x%016" PRIx64 " ", emu_priv, emu_pc);
-                log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, " (0x%08x) ", emu_insn);
-                log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "[error] EMU %cCAUSE %d != DUT %cCAUSE %d\n",
-                                                                          priv, cause, priv, r->common.pending_exception);
-                (m.error_log)(hartid, log_buffer);
+                (m.error_log)(hartid, "%d 0x%016" PRIx64 "  (0x%08x) [error] EMU %cCAUSE %d != DUT %cCAUSE %d\n",
+                              emu_priv, emu_pc, emu_insn, priv, cause, priv, r->common.pending_exception);
 
                 return 0x1FFF;
             }
@@ -400,28 +430,24 @@ int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t du
         handle_dut_overrides(s, emu_priv, emu_pc, emu_insn, emu_wdata, dut_wdata);
     }
 
-    log_buff_space = 0;
-    if (verbose) {
-        log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "%d 0x%016" PRIx64 " ", emu_priv, emu_pc);
-        log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "(0x%08x) ", emu_insn);
-    }
-
+    /*
+     * The logger does the formatting, so a testbench that routes the per
+     * step log nowhere pays nothing for it.
+     */
     if (iregno > 0) {
         emu_wdata      = riscv_get_reg(s, iregno);
         emu_wrote_data = 1;
-        if (verbose)
-            log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "x%-2d 0x%016" PRIx64, iregno, emu_wdata);
+        (m.debug_log)(hartid, "%d 0x%016" PRIx64 " (0x%08x) x%-2d 0x%016" PRIx64 " DASM(0x%08x)\n",
+                      emu_priv, emu_pc, emu_insn, iregno, emu_wdata, emu_insn);
     } else if (fregno >= 0) {
         emu_wdata      = riscv_get_fpreg(s, fregno);
         emu_wrote_data = 1;
-        if (verbose)
-            log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "f%-2d 0x%016" PRIx64, fregno, emu_wdata);
-    } else if (verbose)
-        log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, "                      ");
-
-    if (verbose)
-        log_buff_space += snprintf(log_buffer+log_buff_space, 512-log_buff_space, " DASM(0x%08x)\n", emu_insn);
-    (m.debug_log)(hartid, log_buffer);
+        (m.debug_log)(hartid, "%d 0x%016" PRIx64 " (0x%08x) f%-2d 0x%016" PRIx64 " DASM(0x%08x)\n",
+                      emu_priv, emu_pc, emu_insn, fregno, emu_wdata, emu_insn);
+    } else {
+        (m.debug_log)(hartid, "%d 0x%016" PRIx64 " (0x%08x)                        DASM(0x%08x)\n",
+                      emu_priv, emu_pc, emu_insn, emu_insn);
+    }
 
     if (!check)
         return 0;
@@ -447,8 +473,67 @@ int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t du
 
     riscv_cpu_sync_regs(s);
 
-    if (exit_code == 0)
-        riscv_cpu_sync_regs(s);
+    return exit_code;
+}
+
+int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t dut_pc, uint32_t dut_insn, uint64_t dut_wdata,
+                       uint64_t dut_mstatus, bool check) {
+    RISCVMachine *r = (RISCVMachine *)state;
+    assert(r->ncpus > hartid);
+
+    if (r->common.cosim_async) {
+        CosimAsyncEntry e = {};
+        e.kind    = CosimAsyncEntry::COMMIT;
+        e.check   = check;
+        e.hartid  = hartid;
+        e.insn    = dut_insn;
+        e.addr    = dut_pc;
+        e.data    = dut_wdata;
+        e.mstatus = dut_mstatus;
+        return cosim_async_push(r, e);
+    }
+
+    return cosim_step(r, r->cpu_state[hartid], hartid, dut_pc, dut_insn, dut_wdata, dut_mstatus, check);
+}
+
+/*
+ * majordomo_cosim_step_array --
+ *
+ * Steps through n commit records of one hart in a single call, in
+ * order, stopping at the first one that does not return zero.  Each
+ * record gets exactly the majordomo_cosim_step() treatment, one
+ * instruction at a time; only the call from the DUT is amortized.
+ * Returns that record's exit code, or zero when all n matched, and sets
+ * *n_done to the index of the failing record (n when all matched).
+ */
+int majordomo_cosim_step_array(majordomo_cosim_state_t *state, int hartid, const majordomo_cosim_commit_t *commits, int n,
+                             bool check, int *n_done) {
+    RISCVMachine *r = (RISCVMachine *)state;
+    assert(r->ncpus > hartid);
+    RISCVCPUState *s = r->cpu_state[hartid];
+
+    int i, exit_code = 0;
+    for (i = 0; i < n; ++i) {
+        const majordomo_cosim_commit_t &c = commits[i];
+        if (r->common.cosim_async) {
+            CosimAsyncEntry e = {};
+            e.kind    = CosimAsyncEntry::COMMIT;
+            e.check   = check;
+            e.hartid  = hartid;
+            e.insn    = c.insn;
+            e.addr    = c.pc;
+            e.data    = c.wdata;
+            e.mstatus = c.mstatus;
+            exit_code = cosim_async_push(r, e);
+        } else {
+            exit_code = cosim_step(r, s, hartid, c.pc, c.insn, c.wdata, c.mstatus, check);
+        }
+        if (exit_code)
+            break;
+    }
+
+    if (n_done)
+        *n_done = i;
 
     return exit_code;
 }
@@ -458,10 +543,9 @@ int majordomo_cosim_step(majordomo_cosim_state_t *state, int hartid, uint64_t du
  *
  * DUT sets majordomo memory. Used so that other devices (i.e. block device, accelerators, can write to memory).
  */
-int majordomo_cosim_override_mem(majordomo_cosim_state_t *state, int hartid, uint64_t dut_paddr, uint64_t dut_val, int size_log2) {
-    RISCVMachine * r = (RISCVMachine *)state;
+static int cosim_override_mem(RISCVMachine *r, int hartid, uint64_t dut_paddr, uint64_t dut_val, int size_log2) {
     RISCVCPUState *s = r->cpu_state[hartid];
-    VirtMachine m = r->common;
+    VirtMachine   &m = r->common;
 
     uint8_t *        ptr;
     target_ulong     offset;
@@ -509,14 +593,172 @@ int majordomo_cosim_override_mem(majordomo_cosim_state_t *state, int hartid, uin
     return 0;
 }
 
+int majordomo_cosim_override_mem(majordomo_cosim_state_t *state, int hartid, uint64_t dut_paddr, uint64_t dut_val, int size_log2) {
+    RISCVMachine *r = (RISCVMachine *)state;
+
+    if (r->common.cosim_async) {
+        CosimAsyncEntry e = {};
+        e.kind      = CosimAsyncEntry::MEM;
+        e.hartid    = hartid;
+        e.size_log2 = (int8_t)size_log2;
+        e.addr      = dut_paddr;
+        e.data      = dut_val;
+        cosim_async_push(r, e);
+        return 0;
+    }
+
+    return cosim_override_mem(r, hartid, dut_paddr, dut_val, size_log2);
+}
+
 /*
  * majordomo_install_new_loggers --
  *
- * Sets logging/error functions.
+ * Sets logging/error functions.  In async mode the checker thread calls
+ * them, so the queue is drained first: the checker is then idle until the
+ * next push, whose release of head publishes the new pointers to it.
  */
 void majordomo_install_new_loggers(majordomo_cosim_state_t *state, majordomo_logging_func_t *debug_log,
                                  majordomo_logging_func_t *error_log) {
     VirtMachine *m = (VirtMachine *)state;
+    majordomo_cosim_async_drain(state, NULL);
     m->debug_log = debug_log;
     m->error_log = error_log;
 }
+
+/*
+ * Decoupled checking --
+ *
+ * The DUT thread is the only producer and the checker thread the only
+ * consumer of a power of two ring, so head and tail are all the
+ * synchronization needed.  The first non-zero step result is sticky:
+ * the checker keeps draining the ring without executing so the DUT is
+ * never left stalled on a full queue.
+ */
+struct CosimAsync {
+    std::vector<CosimAsyncEntry> ring;
+    uint64_t                     mask;
+
+    alignas(64) std::atomic<uint64_t> head{0};  // next entry the DUT writes
+    alignas(64) std::atomic<uint64_t> tail{0};  // next entry the checker runs
+
+    alignas(64) std::atomic<int> exit_code{0};
+    uint64_t         fail_index = 0;  // commit index of the first failure
+    std::atomic<bool> stop{false};
+
+    std::thread checker;
+};
+
+static inline void cosim_async_wait(unsigned &spins) {
+    if (++spins < 64)
+        return;
+    spins = 0;
+    std::this_thread::yield();
+}
+
+static void cosim_async_main(RISCVMachine *r, CosimAsync *q) {
+    uint64_t tail    = q->tail.load(std::memory_order_relaxed);
+    uint64_t commits = 0;
+    unsigned spins   = 0;
+
+    for (;;) {
+        uint64_t head = q->head.load(std::memory_order_acquire);
+        if (tail == head) {
+            if (q->stop.load(std::memory_order_acquire) && tail == q->head.load(std::memory_order_acquire))
+                return;
+            cosim_async_wait(spins);
+            continue;
+        }
+
+        for (; tail != head; ++tail) {
+            const CosimAsyncEntry &e = q->ring[tail & q->mask];
+
+            if (q->exit_code.load(std::memory_order_relaxed) == 0) {
+                switch (e.kind) {
+                    case CosimAsyncEntry::COMMIT: {
+                        int exit_code = cosim_step(r, r->cpu_state[e.hartid], e.hartid, e.addr, e.insn, e.data,
+                                                   e.mstatus, e.check);
+                        if (exit_code) {
+                            q->fail_index = commits;
+                            q->exit_code.store(exit_code, std::memory_order_release);
+                        }
+                        break;
+                    }
+                    case CosimAsyncEntry::TRAP: cosim_raise_trap(&r->common, e.hartid, (int64_t)e.data); break;
+                    case CosimAsyncEntry::MEM:
+                        cosim_override_mem(r, e.hartid, e.addr, e.data, e.size_log2);
+                        break;
+                }
+            }
+            if (e.kind == CosimAsyncEntry::COMMIT)
+                ++commits;
+
+            q->tail.store(tail + 1, std::memory_order_release);
+        }
+    }
+}
+
+static int cosim_async_push(RISCVMachine *r, const CosimAsyncEntry &e) {
+    CosimAsync *q       = r->common.cosim_async;
+    uint64_t    head    = q->head.load(std::memory_order_relaxed);
+    unsigned    spins   = 0;
+
+    // The DUT only stalls here, on a full queue
+    while (head - q->tail.load(std::memory_order_acquire) > q->mask) cosim_async_wait(spins);
+
+    q->ring[head & q->mask] = e;
+    q->head.store(head + 1, std::memory_order_release);
+
+    return q->exit_code.load(std::memory_order_acquire);
+}
+
+static void cosim_async_stop(RISCVMachine *r) {
+    CosimAsync *q = r->common.cosim_async;
+    if (!q)
+        return;
+
+    q->stop.store(true, std::memory_order_release);
+    q->checker.join();
+
+    r->common.cosim_async = nullptr;
+    delete q;
+}
+
+int majordomo_cosim_async_start(majordomo_cosim_state_t *state, int depth) {
+    RISCVMachine *r = (RISCVMachine *)state;
+
+    if (r->common.cosim_async || depth < 1)
+        return -1;
+
+    uint64_t size = 1;
+    while (size < (uint64_t)depth) size <<= 1;
+
+    CosimAsync *q = new CosimAsync;
+    q->ring.resize(size);
+    q->mask = size - 1;
+
+    r->common.cosim_async = q;
+    q->checker            = std::thread(cosim_async_main, r, q);
+    return 0;
+}
+
+int majordomo_cosim_async_drain(majordomo_cosim_state_t *state, uint64_t *fail_index) {
+    RISCVMachine *r = (RISCVMachine *)state;
+    CosimAsync   *q = r->common.cosim_async;
+    if (!q)
+        return 0;
+
+    uint64_t head  = q->head.load(std::memory_order_relaxed);
+    unsigned spins = 0;
+    while (q->tail.load(std::memory_order_acquire) != head) cosim_async_wait(spins);
+
+    int exit_code = q->exit_code.load(std::memory_order_acquire);
+    if (exit_code && fail_index)
+        *fail_index = q->fail_index;
+    return exit_code;
+}
+
+int majordomo_cosim_async_stop(majordomo_cosim_state_t *state, uint64_t *fail_index) {
+    int exit_code = majordomo_cosim_async_drain(state, fail_index);
+    cosim_async_stop((RISCVMachine *)state);
+    return exit_code;
+}
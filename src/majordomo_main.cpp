@@ -52,10 +52,17 @@ FILE *majordomo_trace;
 FILE *majordomo_stdout;
 FILE *majordomo_stderr;
 
-BOOL virt_machine_run(RISCVMachine *s, int hartid, int n_cycles) {
+BOOL virt_machine_run(RISCVMachine *s, int hartid, int n_cycles, int *n_executed) {
     (void)virt_machine_get_sleep_duration(s, hartid, MAX_SLEEP_TIME);
 
-    riscv_cpu_interp64(s->cpu_state[hartid], n_cycles);
+    int n;
+    if (s->common.ffwd || s->common.live_cache_ffwd)
+        n = riscv_cpu_interp_ffwd64(s->cpu_state[hartid], n_cycles);
+    else
+        n = riscv_cpu_interp64(s->cpu_state[hartid], n_cycles);
+    if (n_executed)
+        *n_executed = n;
+
     RISCVCPUState *cpu = s->cpu_state[hartid];
     if (s->htif_tohost_addr) {
         uint32_t tohost;
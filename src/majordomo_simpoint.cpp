@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "majordomo_simpoint.h"
+#include "riscv_cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
+#include <random>
+#include <thread>
+
+extern FILE *majordomo_stderr;
+
+// =========================================================================
+// Helpers
+// =========================================================================
+// splitmix64, used to generate the projection matrix on the fly so it
+// never has to be materialized for large basic block counts
+static inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+// -------------------------------------------------------------------------
+// Uniform [-1,1) projection coefficient for (basic block, dimension)
+// -------------------------------------------------------------------------
+static inline double proj_coef(uint64_t seed, uint32_t bb, int d, int dim) {
+    uint64_t h = mix64(seed ^ ((uint64_t)bb * (uint64_t)dim + (uint64_t)d));
+    return (double)(h >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+// -------------------------------------------------------------------------
+static inline double dist2(const double *a, const double *b, int dim) {
+    double s = 0.0;
+    for (int d = 0; d < dim; ++d) {
+        double t = a[d] - b[d];
+        s += t * t;
+    }
+    return s;
+}
+
+// =========================================================================
+// k-means
+// =========================================================================
+struct KmeansResult {
+    double              distortion = DBL_MAX;
+    std::vector<int>    label;
+    std::vector<double> center;   // k * dim
+};
+// -------------------------------------------------------------------------
+// One k-means run, k-means++ seeding followed by Lloyd iterations
+// -------------------------------------------------------------------------
+static void kmeans_run(const std::vector<double> &pts, int n, int dim, int k,
+                       int max_iter, uint64_t seed, KmeansResult &r) {
+    std::mt19937_64 rng(seed);
+
+    r.center.assign((size_t)k * dim, 0.0);
+    r.label.assign(n, -1);
+
+    // k-means++ seeding
+    std::vector<double> dmin(n, DBL_MAX);
+    int first = (int)(rng() % (uint64_t)n);
+    std::copy_n(&pts[(size_t)first * dim], dim, &r.center[0]);
+
+    for (int c = 1; c < k; ++c) {
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double d = dist2(&pts[(size_t)i * dim], &r.center[(size_t)(c - 1) * dim], dim);
+            dmin[i] = std::min(dmin[i], d);
+            sum += dmin[i];
+        }
+
+        int pick = (int)(rng() % (uint64_t)n);
+        if (sum > 0.0) {
+            double target = std::uniform_real_distribution<double>(0.0, sum)(rng);
+            for (int i = 0; i < n; ++i) {
+                target -= dmin[i];
+                if (target <= 0.0) {
+                    pick = i;
+                    break;
+                }
+            }
+        }
+        std::copy_n(&pts[(size_t)pick * dim], dim, &r.center[(size_t)c * dim]);
+    }
+
+    // Lloyd
+    std::vector<double> sum((size_t)k * dim);
+    std::vector<int>    cnt(k);
+
+    for (int it = 0; it < max_iter; ++it) {
+        bool changed = false;
+        for (int i = 0; i < n; ++i) {
+            const double *p    = &pts[(size_t)i * dim];
+            int           best = 0;
+            double        bd   = DBL_MAX;
+            for (int c = 0; c < k; ++c) {
+                double d = dist2(p, &r.center[(size_t)c * dim], dim);
+                if (d < bd) {
+                    bd   = d;
+                    best = c;
+                }
+            }
+            if (r.label[i] != best) {
+                r.label[i] = best;
+                changed    = true;
+            }
+        }
+
+        if (!changed) break;
+
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(cnt.begin(), cnt.end(), 0);
+        for (int i = 0; i < n; ++i) {
+            int c = r.label[i];
+            cnt[c]++;
+            for (int d = 0; d < dim; ++d) sum[(size_t)c * dim + d] += pts[(size_t)i * dim + d];
+        }
+        // An emptied cluster keeps its old center
+        for (int c = 0; c < k; ++c) {
+            if (cnt[c] == 0) continue;
+            for (int d = 0; d < dim; ++d)
+                r.center[(size_t)c * dim + d] = sum[(size_t)c * dim + d] / cnt[c];
+        }
+    }
+
+    r.distortion = 0.0;
+    for (int i = 0; i < n; ++i)
+        r.distortion += dist2(&pts[(size_t)i * dim], &r.center[(size_t)r.label[i] * dim], dim);
+}
+// -------------------------------------------------------------------------
+// BIC of a clustering (Pelleg & Moore, spherical gaussians with a shared
+// per-dimension variance)
+// -------------------------------------------------------------------------
+static double kmeans_bic(const KmeansResult &r, int n, int dim, int k) {
+    std::vector<int> cnt(k, 0);
+    for (int l : r.label) cnt[l]++;
+
+    double var = (n > k) ? r.distortion / ((double)dim * (n - k)) : 0.0;
+    var        = std::max(var, 1e-12);
+
+    double ll = -0.5 * n * dim * std::log(2.0 * M_PI * var) - 0.5 * dim * (n - k);
+    for (int c = 0; c < k; ++c) {
+        if (cnt[c]) ll += cnt[c] * std::log((double)cnt[c] / n);
+    }
+
+    double params = (double)k * (dim + 1);
+    return ll - 0.5 * params * std::log((double)n);
+}
+
+// =========================================================================
+// Public interface
+// =========================================================================
+std::vector<SimpointPick> simpoint_cluster(const std::vector<SimpointBbv> &intervals,
+                                           const SimpointClusterParams &params) {
+    std::vector<SimpointPick> picks;
+
+    int n   = (int)intervals.size();
+    int dim = std::max(1, params.dim);
+    if (n == 0) return picks;
+
+    // Normalize each interval to unit mass and project it
+    std::vector<double> pts((size_t)n * dim, 0.0);
+    for (int i = 0; i < n; ++i) {
+        double total = 0.0;
+        for (const auto &e : intervals[i].bb) total += (double)e.second;
+        if (total == 0.0) continue;
+
+        double *p = &pts[(size_t)i * dim];
+        for (const auto &e : intervals[i].bb) {
+            double f = (double)e.second / total;
+            for (int d = 0; d < dim; ++d) p[d] += f * proj_coef(params.seed, e.first, d, dim);
+        }
+    }
+
+    int max_k = std::max(1, std::min(params.max_k, n));
+    int nthr  = params.num_threads > 0 ? params.num_threads : (int)std::thread::hardware_concurrency();
+    nthr      = std::max(1, std::min(nthr, max_k));
+
+    // One task per k, largest k first so the long runs start early
+    std::vector<KmeansResult> best(max_k + 1);
+    std::vector<double>       bic(max_k + 1, -DBL_MAX);
+    std::atomic<int>          next_k(max_k);
+
+    auto worker = [&]() {
+        for (int k = next_k--; k >= 1; k = next_k--) {
+            for (int s = 0; s < std::max(1, params.num_seeds); ++s) {
+                KmeansResult r;
+                kmeans_run(pts, n, dim, k, params.max_iter,
+                           mix64(params.seed + (uint64_t)k * 1000003ULL + (uint64_t)s), r);
+                if (r.distortion < best[k].distortion) best[k] = std::move(r);
+            }
+            bic[k] = kmeans_bic(best[k], n, dim, k);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < nthr; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+
+    // Smallest k that scores within bic_ratio of the BIC range
+    double lo = DBL_MAX, hi = -DBL_MAX;
+    for (int k = 1; k <= max_k; ++k) {
+        lo = std::min(lo, bic[k]);
+        hi = std::max(hi, bic[k]);
+    }
+    int kpick = max_k;
+    for (int k = 1; k <= max_k; ++k) {
+        if (bic[k] >= lo + params.bic_ratio * (hi - lo)) {
+            kpick = k;
+            break;
+        }
+    }
+
+    // Representative: the interval nearest its cluster center
+    const KmeansResult &r = best[kpick];
+    std::vector<int>    rep(kpick, -1);
+    std::vector<double> rep_d(kpick, DBL_MAX);
+    std::vector<int>    cnt(kpick, 0);
+    for (int i = 0; i < n; ++i) {
+        int    c = r.label[i];
+        double d = dist2(&pts[(size_t)i * dim], &r.center[(size_t)c * dim], dim);
+        cnt[c]++;
+        if (d < rep_d[c]) {
+            rep_d[c] = d;
+            rep[c]   = i;
+        }
+    }
+
+    int id = 0;
+    for (int c = 0; c < kpick; ++c) {
+        if (rep[c] < 0) continue;
+        picks.push_back({(uint64_t)rep[c], id++, (double)cnt[c] / n});
+    }
+
+    fprintf(majordomo_stderr, "simpoint: %d intervals, %d threads, k=%d selected (max %d)\n",
+            n, nthr, (int)picks.size(), max_k);
+
+    return picks;
+}
+// -------------------------------------------------------------------------
+// -------------------------------------------------------------------------
+bool simpoint_write(const std::vector<SimpointPick> &picks,
+                    const char *simpoints_name, const char *weights_name) {
+    FILE *sp = fopen(simpoints_name, "w");
+    if (!sp) {
+        fprintf(majordomo_stderr, "could not open simpoint file %s\n", simpoints_name);
+        return false;
+    }
+    FILE *wt = fopen(weights_name, "w");
+    if (!wt) {
+        fprintf(majordomo_stderr, "could not open simpoint weights file %s\n", weights_name);
+        fclose(sp);
+        return false;
+    }
+
+    for (const auto &p : picks) {
+        fprintf(sp, "%" PRIu64 " %d\n", p.interval, p.id);
+        fprintf(wt, "%.9g %d\n", p.weight, p.id);
+    }
+
+    fclose(sp);
+    fclose(wt);
+    return true;
+}
+// -------------------------------------------------------------------------
+// -------------------------------------------------------------------------
+void simpoint_add(VirtMachine *vm, uint64_t interval, int id) {
+    uint64_t start = interval * vm->simpoint_size;
+
+    if (start == 0) {  // skip boot ROM
+        start = ROM_SIZE;
+    }
+
+    vm->simpoints.push_back({start, id});
+}
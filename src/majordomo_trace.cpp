@@ -66,7 +66,7 @@ void execution_trace(RISCVMachine *m,int hartid,uint32_t insn_raw) {
           for (int i = 31; i >= 0; i--) {
               if (cpu->most_recently_written_vregs[i]) {
                   fprintf(majordomo_trace, " v%2d 0x", i);
-                  for (int j = VLEN / 8 - 1; j >= 0; j--) {
+                  for (int j = cpu->vlen / 8 - 1; j >= 0; j--) {
                       fprintf(majordomo_stderr, "%02" PRIx8, cpu->v_reg[i][j]);
                   }
               }
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "majordomo_warmup.h"
+
+#include <cstdio>
+#include <cstring>
+
+extern FILE *majordomo_stderr;
+
+static const char     warmup_magic[8] = {'M', 'D', 'W', 'A', 'R', 'M', 'U', 'P'};
+static const uint32_t warmup_version  = 1;
+
+// =========================================================================
+// Encoding helpers
+// =========================================================================
+static void put_u8(std::vector<uint8_t> &b, uint8_t v) { b.push_back(v); }
+// -------------------------------------------------------------------------
+static void put_u32(std::vector<uint8_t> &b, uint32_t v) {
+    for (int i = 0; i < 4; ++i) b.push_back((uint8_t)(v >> (8 * i)));
+}
+// -------------------------------------------------------------------------
+static void put_u64(std::vector<uint8_t> &b, uint64_t v) {
+    for (int i = 0; i < 8; ++i) b.push_back((uint8_t)(v >> (8 * i)));
+}
+// -------------------------------------------------------------------------
+static void put_str(std::vector<uint8_t> &b, const std::string &s) {
+    put_u32(b, (uint32_t)s.size());
+    b.insert(b.end(), s.begin(), s.end());
+}
+// -------------------------------------------------------------------------
+static void put_uleb(std::vector<uint8_t> &b, uint64_t v) {
+    do {
+        uint8_t c = v & 0x7f;
+        v >>= 7;
+        b.push_back(c | (v ? 0x80 : 0));
+    } while (v);
+}
+
+// -------------------------------------------------------------------------
+// Bounds checked reader over the whole file
+// -------------------------------------------------------------------------
+struct WarmupReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool           ok = true;
+
+    bool need(size_t n) {
+        if (ok && (size_t)(end - p) < n) ok = false;
+        return ok;
+    }
+    uint64_t get(int bytes) {
+        uint64_t v = 0;
+        if (!need(bytes)) return 0;
+        for (int i = 0; i < bytes; ++i) v |= (uint64_t)p[i] << (8 * i);
+        p += bytes;
+        return v;
+    }
+    std::string get_str() {
+        uint32_t n = (uint32_t)get(4);
+        if (!need(n)) return std::string();
+        std::string s((const char *)p, n);
+        p += n;
+        return s;
+    }
+    uint64_t get_uleb() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!need(1)) return 0;
+            uint8_t c = *p++;
+            v |= (uint64_t)(c & 0x7f) << shift;
+            if (!(c & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+static inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static inline int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static inline int line_bits(uint32_t line_size) {
+    int b = 0;
+    while ((1u << b) < line_size) ++b;
+    return b;
+}
+
+// =========================================================================
+// Public interface
+// =========================================================================
+bool warmup_write(const char *file_name, const std::vector<WarmupLevel> &levels) {
+    std::vector<uint8_t> b;
+
+    b.insert(b.end(), warmup_magic, warmup_magic + sizeof warmup_magic);
+    put_u32(b, warmup_version);
+    put_u32(b, (uint32_t)levels.size());
+
+    std::vector<uint8_t> stream;
+    for (const auto &l : levels) {
+        put_str(b, l.name);
+        put_str(b, l.policy);
+        put_u64(b, l.size);
+        put_u32(b, l.assoc);
+        put_u32(b, l.line_size);
+        put_u8(b, l.side);
+        put_u8(b, l.inclusion);
+
+        int      shift = line_bits(l.line_size);
+        uint64_t prev  = 0;
+        stream.clear();
+        for (uint64_t a : l.lines) {
+            uint64_t line = a >> shift;
+            put_uleb(stream, (zigzag((int64_t)(line - prev)) << 1) | (a & 1));
+            prev = line;
+        }
+
+        put_u64(b, l.lines.size());
+        put_u64(b, stream.size());
+        b.insert(b.end(), stream.begin(), stream.end());
+    }
+
+    FILE *f = fopen(file_name, "wb");
+    if (!f) {
+        fprintf(majordomo_stderr, "could not open warmup file %s\n", file_name);
+        return false;
+    }
+    bool ok = fwrite(b.data(), 1, b.size(), f) == b.size();
+    ok      = fclose(f) == 0 && ok;
+    if (!ok) fprintf(majordomo_stderr, "%s: write error\n", file_name);
+    return ok;
+}
+// -------------------------------------------------------------------------
+// -------------------------------------------------------------------------
+bool warmup_read(const char *file_name, std::vector<WarmupLevel> &levels) {
+    FILE *f = fopen(file_name, "rb");
+    if (!f) {
+        fprintf(majordomo_stderr, "could not open warmup file %s\n", file_name);
+        return false;
+    }
+    std::vector<uint8_t> b;
+    uint8_t              chunk[65536];
+    size_t               n;
+    while ((n = fread(chunk, 1, sizeof chunk, f)) > 0) b.insert(b.end(), chunk, chunk + n);
+    fclose(f);
+
+    WarmupReader r{b.data(), b.data() + b.size()};
+
+    if (!r.need(sizeof warmup_magic) || memcmp(r.p, warmup_magic, sizeof warmup_magic)) {
+        fprintf(majordomo_stderr, "%s: not a warmup file\n", file_name);
+        return false;
+    }
+    r.p += sizeof warmup_magic;
+
+    uint32_t version = (uint32_t)r.get(4);
+    if (r.ok && version != warmup_version) {
+        fprintf(majordomo_stderr, "%s: unsupported warmup file version %u\n", file_name, version);
+        return false;
+    }
+
+    uint32_t n_levels = (uint32_t)r.get(4);
+    levels.clear();
+    for (uint32_t i = 0; r.ok && i < n_levels; ++i) {
+        WarmupLevel l;
+        l.name      = r.get_str();
+        l.policy    = r.get_str();
+        l.size      = r.get(8);
+        l.assoc     = (uint32_t)r.get(4);
+        l.line_size = (uint32_t)r.get(4);
+        l.side      = (uint8_t)r.get(1);
+        l.inclusion = (uint8_t)r.get(1);
+
+        uint64_t n_lines = r.get(8);
+        uint64_t n_bytes = r.get(8);
+        if (!r.need(n_bytes) || n_lines > n_bytes) {
+            r.ok = false;
+            break;
+        }
+
+        WarmupReader s{r.p, r.p + n_bytes};
+        int          shift = line_bits(l.line_size);
+        uint64_t     prev  = 0;
+        l.lines.reserve(n_lines);
+        for (uint64_t j = 0; s.ok && j < n_lines; ++j) {
+            uint64_t v    = s.get_uleb();
+            uint64_t line = prev + (uint64_t)unzigzag(v >> 1);
+            l.lines.push_back((line << shift) | (v & 1));
+            prev = line;
+        }
+        r.ok = s.ok;
+        r.p += n_bytes;
+
+        levels.push_back(std::move(l));
+    }
+
+    if (!r.ok) {
+        fprintf(majordomo_stderr, "%s: truncated or corrupt warmup file\n", file_name);
+        return false;
+    }
+    return true;
+}
+// -------------------------------------------------------------------------
+// -------------------------------------------------------------------------
+std::vector<uint64_t> warmup_replay_list(const std::vector<WarmupLevel> &levels) {
+    size_t n = 0;
+    for (const auto &l : levels) n += l.lines.size();
+
+    std::vector<uint64_t> list;
+    list.reserve(n);
+    for (size_t i = levels.size(); i-- > 0;)
+        list.insert(list.end(), levels[i].lines.begin(), levels[i].lines.end());
+    return list;
+}
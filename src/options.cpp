@@ -50,6 +50,11 @@ void usage_isa()
   for (const auto& [key, _] : extensionMap) {
       fprintf(stdout, "  -  %s\n", key.c_str());
   }
+  fprintf(majordomo_stderr,"\nInterpreter profiles\n");
+  for (int i = 0; i < isa_num_profiles; ++i) {
+      fprintf(stdout, "  -  %-8s --march %s\n", isa_profiles[i].name,
+              isa_profiles[i].march);
+  }
   exit(1);
 }
 
@@ -80,12 +85,18 @@ void usage(const char *prog, const char *msg) {
 "\n"
 "  ISA selection options EXPERIMENTAL\n"
 "    --march <string>    Specify the architecture string to enable\n"
-"                        supported ISA extensions, default is rv64gc.\n"
+"                        supported ISA extensions, default is all of them.\n"
+"                        It has to name exactly the extensions of one\n"
+"                        interpreter profile, see --help-march.\n"
 "                        Use --help-march to see currently supported set.\n"
 "    --show-march        Takes a complete option set and shows the\n"
 "                        enabled extensions. Then exits. \n"
 "    --custom_extension  Set the custom extension bit in the misa \n"
 "                        in all cores\n"
+"    --vlen <bits>       Vector register width, overrides zvl<N>b in\n"
+"                        --march and \"vlen\" in the config (default 128)\n"
+"    --elen <bits>       Widest vector element, overrides zve<N> in\n"
+"                        --march and \"elen\" in the config (default 64)\n"
 
 "\n"
 "  STF trace options\n"
@@ -120,6 +131,18 @@ void usage(const char *prog, const char *msg) {
 "    --simpoint_en_bbv Enable bbv collection\n"
 "    --simpoint_bb_file <filename>  Name of file to dump simpoint.bb\n"
 "    --simpoint_size <n> Simpoint size for bbv collection \n"
+"    --simpoint_roi_at_reset Collect from reset instead of waiting\n"
+"                   for the ROI start marker\n"
+"    --simpoint_cluster Cluster the bbvs in-tree at the end of the run\n"
+"                   and write the simpoints and weights files\n"
+"    --simpoint_auto Collect bbvs, cluster, then re-run and create a\n"
+"                   checkpoint for each simpoint (implies\n"
+"                   --simpoint_en_bbv and --simpoint_cluster)\n"
+"    --simpoint_maxk <n> Maximum number of clusters (default 30)\n"
+"    --simpoint_dim <n> Random projection dimensions (default 15)\n"
+"    --simpoint_threads <n> Clustering threads (default one per cpu)\n"
+"    --simpoint_out <prefix> Write <prefix>.simpoints and\n"
+"                   <prefix>.weights (default majordomo_simpoint)\n"
 
 "\n"
 "  Execution trace options\n"
@@ -138,8 +161,22 @@ void usage(const char *prog, const char *msg) {
 "    --ncpus number of cpus to simulate (default 1)\n"
 "    --load resumes a previously saved snapshot\n"
 "    --save saves a snapshot upon exit\n"
+"    --warmup_restore loop|preload restore the warm set of a WARMUP\n"
+"                   checkpoint by replaying it from the boot rom (default)\n"
+"                   or by pre-loading the cache model (LIVECACHE builds)\n"
+"    --checkpoint_async <n> write simpoint checkpoints from up to n\n"
+"                   forked background writers, 0 blocks\n"
+"                   (default one per spare host cpu, at most 4)\n"
 "    --maxinsns terminates execution after a number of instructions\n"
+"    --fast_forward <n> run the fast-forward engine, without tracing\n"
+"                   or warmup observers, for the first n instructions\n"
+"    --fast_forward_pc <addr> run the fast-forward engine until the\n"
+"                   pc reaches addr\n"
 "    --heartbeat <n> Print heartbeat after executing every n instructions \n"
+"    --stats_file <file> write end of run instruction counts, MIPS\n"
+"                   and host time to file, JSON\n"
+"    --cpu_layout  print the RISCVCPUState field layout at the end of\n"
+"                  the run, with access counts in CPU_FIELD_STATS builds\n"
 "    --terminate-event name of the validate event to terminate \n"
 "                  execution\n"
 "    --ignore_sbi_shutdown continue simulation even upon seeing \n"
@@ -164,6 +201,11 @@ void usage(const char *prog, const char *msg) {
 #ifdef LIVECACHE
 "    --live_cache_size live cache warmup for checkpoint \n"
 "                   (default 8M)\n"
+"    --live_cache_config <file> live cache hierarchy, JSON, see\n"
+"                   doc/livecache.md\n"
+"    --live_cache_window n only track the last n instructions before\n"
+"                   a checkpoint, fast-forward the rest (default 0,\n"
+"                   track from reset)\n"
 #endif
 "    --clear_ids clear mvendorid, marchid, mimpid for all cores\n\n"
         ,
@@ -409,7 +451,8 @@ void Options::build_options(po::options_description &stdOpts,
     ("march",
        po::value<string>(&march_string),
        "Specify the architecture string to enable "
-       "supported ISA extensions, default is rv64gc. "
+       "supported ISA extensions, default is all of them. It has to "
+       "name exactly the extensions of one interpreter profile. "
        "Use --help-march to see currently supported set."
     )
 
@@ -420,6 +463,16 @@ void Options::build_options(po::options_description &stdOpts,
     ("custom_extension",
        po::bool_switch(&custom_extension)->default_value(false),
        "Set the custom extension bit in the misa in all cores")
+
+    ("vlen",
+       po::value<uint64_t>(&vlen),
+       "Vector register width in bits, overrides zvl<N>b in --march "
+       "and \"vlen\" in the config")
+
+    ("elen",
+       po::value<uint64_t>(&elen),
+       "Widest vector element in bits, overrides zve<N> in --march "
+       "and \"elen\" in the config")
   ;
 
   stfOpts.add_options()
@@ -486,6 +539,41 @@ void Options::build_options(po::options_description &stdOpts,
     ("simpoint_size",
        po::value<uint64_t>(&simpoint_size),
        "Simpoint size for bbv collection")
+
+    ("simpoint_roi_at_reset",
+       po::bool_switch(&simpoint_roi_at_reset)->default_value(false),
+       "Collect from reset instead of waiting for the ROI start marker")
+
+    ("simpoint_cluster",
+       po::bool_switch(&simpoint_cluster)->default_value(false),
+       "Cluster the bbvs in-tree at the end of the run and write the "
+       "simpoints and weights files")
+
+    ("simpoint_auto",
+       po::bool_switch(&simpoint_auto)->default_value(false),
+       "Collect bbvs, cluster, then re-run and create a checkpoint for "
+       "each simpoint")
+
+    ("simpoint_maxk",
+       po::value<int>(&simpoint_maxk),
+       "Maximum number of clusters")
+
+    ("simpoint_dim",
+       po::value<int>(&simpoint_dim),
+       "Random projection dimensions")
+
+    ("simpoint_threads",
+       po::value<int>(&simpoint_threads),
+       "Clustering threads, 0 is one per host cpu")
+
+    ("simpoint_out",
+       po::value<string>(&simpoint_out),
+       "Prefix of the simpoints and weights files")
+
+    ("checkpoint_async",
+       po::value<int>(&checkpoint_async),
+       "Write simpoint checkpoints from up to n forked background "
+       "writers, 0 blocks. Default is one per spare host cpu, at most 4")
 ;
 
   traceOpts.add_options()
@@ -523,14 +611,38 @@ void Options::build_options(po::options_description &stdOpts,
        po::value<string>(&snapshot_save_name),
        "Save a snapshot to named file")
 
+    ("warmup_restore",
+       po::value<string>(&warmup_restore),
+       "Restore the warm set of a WARMUP checkpoint with the boot rom "
+       "replay loop (loop, default) or by pre-loading the cache model "
+       "(preload)")
+
     ("maxinsns",
        po::value<uint64_t>(&maxinsns),
        "Terminates execution after a number of instructions")
 
+    ("fast_forward",
+       po::value<uint64_t>(&ffwd_until_insns),
+       "Run the fast-forward engine, without tracing or warmup "
+       "observers, for the first n instructions")
+
+    ("fast_forward_pc",
+       po::value<uint64_t>(&ffwd_until_pc),
+       "Run the fast-forward engine until the pc reaches this address")
+
     ("heartbeat",
        po::value<uint64_t>(&heartbeat),
        "Print heartbeat after executing every n instructions")
 
+    ("stats_file",
+       po::value<string>(&stats_file),
+       "Write end of run instruction counts, MIPS and host time to file, JSON")
+
+    ("cpu_layout",
+       po::bool_switch(&cpu_layout)->default_value(false),
+       "Print the RISCVCPUState field layout at the end of the run, with "
+       "access counts in CPU_FIELD_STATS builds")
+
     ("dump_memories",
        po::bool_switch(&dump_memories)->default_value(false),
        "dump memories that could be used to load a cosimulation")
@@ -584,6 +696,17 @@ void Options::build_options(po::options_description &stdOpts,
      "Live cache warmup for checkpoint (default 8M). "
      "Majordomo must be compiled with -DLIVECACHE for this option to "
      "be valid")
+
+    ("live_cache_config",po::value<string>(&live_cache_config),
+     "Live cache hierarchy description, JSON (see doc/livecache.md). "
+     "Majordomo must be compiled with -DLIVECACHE for this option to "
+     "be valid")
+
+    ("live_cache_window",po::value<uint64_t>(&live_cache_window),
+     "Only track the last N instructions before a checkpoint, "
+     "fast-forward the rest (default 0, track from reset). "
+     "Majordomo must be compiled with -DLIVECACHE for this option to "
+     "be valid")
   ;
 
   //Add a placeholder for the positional option
@@ -623,6 +746,28 @@ bool Options::check_options(po::variables_map &vm,
     ok = false;
     #endif
   }
+  if(vm.count("live_cache_config")) {
+    #ifndef LIVECACHE
+    cout<<"-E: Majordomo must be compiled with -DLIVECACHE for "
+        <<"--live_cache_config to have an effect"<<endl;
+    ok = false;
+    #endif
+  }
+  if(vm.count("live_cache_window")) {
+    #ifndef LIVECACHE
+    cout<<"-E: Majordomo must be compiled with -DLIVECACHE for "
+        <<"--live_cache_window to have an effect"<<endl;
+    ok = false;
+    #endif
+  }
+
+  if(warmup_restore == "preload") {
+    #ifndef LIVECACHE
+    cout<<"-E: Majordomo must be compiled with -DLIVECACHE for "
+        <<"--warmup_restore preload, there is no cache model to pre-load"<<endl;
+    ok = false;
+    #endif
+  }
 
 //FIXME: more checks will be added
 
@@ -44,6 +44,7 @@
 #include "options.h"
 #include "iomem.h"
 #include "riscv_machine.h"
+#include "vector_group.h"
 
 #include <assert.h>
 #include <err.h>
@@ -60,38 +61,55 @@ extern int simpoint_roi;
 
 // NOTE: Use GET_INSN_COUNTER not mcycle because this is just to track advancement of simulation
 
-
-#define write_reg(x, val)                                \
-    ({                                                   \
-        if(s->machine->common.stf_in_traceable_region) { \
-            s->stf_write_regs.emplace_back(x);           \
-        }                                                \
-        s->most_recently_written_reg = (x);              \
-        s->reg_prior[x]              = s->reg[x];        \
-        s->reg[x]                    = (val);            \
+// Inside the interpreter FFWD is its template parameter and the
+// fast-forward engine skips the observers. Everywhere else they stay on.
+static constexpr bool FFWD = false;
+
+#define write_reg(x, val)                                    \
+    ({                                                       \
+        if constexpr (!FFWD) {                               \
+            if(s->machine->common.stf_in_traceable_region) { \
+                s->stf_write_regs.emplace_back(x);           \
+            }                                                \
+            s->most_recently_written_reg = (x);              \
+            s->reg_prior[x]              = s->reg[x];        \
+            CPU_FIELD_HIT(s, reg_prior[x]);                  \
+        }                                                    \
+        CPU_FIELD_HIT(s, reg[x]);                            \
+        s->reg[x]                    = (val);                \
     })
-#define read_reg(x)                                      \
-    ({                                                   \
-        if(s->machine->common.stf_in_traceable_region) { \
-            s->stf_read_regs.emplace_back(x);            \
-        }                                                \
-        s->reg[x];                                       \
+#define read_reg(x)                                          \
+    ({                                                       \
+        if constexpr (!FFWD) {                               \
+            if(s->machine->common.stf_in_traceable_region) { \
+                s->stf_read_regs.emplace_back(x);            \
+            }                                                \
+        }                                                    \
+        CPU_FIELD_HIT(s, reg[x]);                            \
+        s->reg[x];                                           \
     })
-#define write_fp_reg(x, val)                             \
-    ({                                                   \
-        if(s->machine->common.stf_in_traceable_region) { \
-            s->stf_write_fp_regs.emplace_back(x);        \
-        }                                                \
-        s->most_recently_written_fp_reg = (x);           \
-        s->fp_reg[x]                    = (val);         \
-        s->fs                           = 3;             \
+#define write_fp_reg(x, val)                                 \
+    ({                                                       \
+        if constexpr (!FFWD) {                               \
+            if(s->machine->common.stf_in_traceable_region) { \
+                s->stf_write_fp_regs.emplace_back(x);        \
+            }                                                \
+            s->most_recently_written_fp_reg = (x);           \
+        }                                                    \
+        CPU_FIELD_HIT(s, fp_reg[x]);                         \
+        CPU_FIELD_HIT(s, fs);                                \
+        s->fp_reg[x]                    = (val);             \
+        s->fs                           = 3;                 \
     })
-#define read_fp_reg(x)                                   \
-    ({                                                   \
-        if(s->machine->common.stf_in_traceable_region) { \
-            s->stf_read_fp_regs.emplace_back(x);         \
-        }                                                \
-        s->fp_reg[x];                                    \
+#define read_fp_reg(x)                                       \
+    ({                                                       \
+        if constexpr (!FFWD) {                               \
+            if(s->machine->common.stf_in_traceable_region) { \
+                s->stf_read_fp_regs.emplace_back(x);         \
+            }                                                \
+        }                                                    \
+        CPU_FIELD_HIT(s, fp_reg[x]);                         \
+        s->fp_reg[x];                                        \
     })
 
 /*
@@ -170,14 +188,20 @@ static void         dump_regs(RISCVCPUState *s) {
 #endif
 }
 
+template <bool FFWD = false>
 static inline void track_write(RISCVCPUState *s, uint64_t vaddr, uint64_t paddr, uint64_t data, int size,bool trace_en = false) {
+    if constexpr (FFWD)
+        return;
+
     // Track write gets size in bits
     // Convert size to bytes if stf_memrecord_size_in_bits is false
     size = s->machine->common.stf_memrecord_size_in_bits ? size : size / 8;
 #ifdef LIVECACHE
-    s->machine->llc->write(paddr);
+    if (s->machine->llc_track)
+        s->machine->llc->write(paddr);
 #endif
     //printf("track.st[%llx:%llx]=%llx\n", paddr, paddr+size-1, data);
+    CPU_FIELD_HIT(s, last_data_vaddr);
     s->last_data_paddr = paddr;
     s->last_data_vaddr = vaddr;
     s->last_data_size  = size;
@@ -196,13 +220,19 @@ static inline void track_write(RISCVCPUState *s, uint64_t vaddr, uint64_t paddr,
     }
 }
 
+template <bool FFWD = false>
 static inline uint64_t track_dread(RISCVCPUState *s, uint64_t vaddr, uint64_t paddr, uint64_t data, int size,bool trace_en = false) {
+    if constexpr (FFWD)
+        return data;
+
     // Track write gets size in bits
     // Convert size to bytes if stf_memrecord_size_in_bits is false
     size = s->machine->common.stf_memrecord_size_in_bits ? size : size / 8;
 #ifdef LIVECACHE
-    s->machine->llc->read(paddr);
+    if (s->machine->llc_track)
+        s->machine->llc->read(paddr);
 #endif
+    CPU_FIELD_HIT(s, last_data_vaddr);
     s->last_data_paddr = paddr;
     s->last_data_vaddr = vaddr;
     s->last_data_size  = size;
@@ -223,9 +253,46 @@ static inline uint64_t track_dread(RISCVCPUState *s, uint64_t vaddr, uint64_t pa
     return data;
 }
 
+/* track_dread/track_write of the eb byte elements of a block access,
+ * with the per access checks done once for the block */
+static void track_block(RISCVCPUState *s, bool ld, uint64_t vaddr, uint64_t paddr, const uint8_t *data, int n, int eb) {
+    int size = s->machine->common.stf_memrecord_size_in_bits ? eb * 8 : eb;
+#ifdef LIVECACHE
+    if (s->machine->llc_track)
+        for (int off = 0; off < n; off += eb) {
+            if (ld)
+                s->machine->llc->read(paddr + off);
+            else
+                s->machine->llc->write(paddr + off);
+        }
+#endif
+    uint64_t last = 0;
+    memcpy(&last, data + n - eb, eb);
+    s->last_data_paddr = paddr + n - eb;
+    s->last_data_vaddr = vaddr + n - eb;
+    s->last_data_size  = size;
+    s->last_data_type  = !ld;
+#ifdef GOLDMEM_INORDER
+    if (!ld)
+        s->last_data_value = last;
+#endif
+
+    if (s->machine->common.stf_macro_tracing_active
+        && riscv_get_priv_level(s->machine->cpu_state[0]) <= s->machine->common.stf_highest_priv_mode) {
+        auto &recs = ld ? s->stf_mem_reads : s->stf_mem_writes;
+        for (int off = 0; off < n; off += eb) {
+            uint64_t v = 0;
+            memcpy(&v, data + off, eb);
+            if (!ld || vaddr + off != s->machine->htif_tohost_addr)
+                recs.emplace_back(vaddr + off, size, v);
+        }
+    }
+}
+
 static inline uint64_t track_iread(RISCVCPUState *s, uint64_t vaddr, uint64_t paddr, uint64_t data, int size) {
 #ifdef LIVECACHE
-    s->machine->llc->read(paddr);
+    if (s->machine->llc_track)
+        s->machine->llc->iread(paddr);
 #endif
     //printf("track.ic[%llx:%llx]=%llx\n", paddr, paddr+size-1, data);
     assert(size == 16 || size == 32);
@@ -284,6 +351,7 @@ static inline PhysMemoryRange *get_phys_mem_range_pmp(RISCVCPUState *s, uint64_t
 }
 
 static inline bool check_triggers(RISCVCPUState *s, target_ulong t_mctl, target_ulong addr) {
+    CPU_FIELD_HIT(s, debug_mode);
     if (s->debug_mode) //Triggers do not fire while in Debug Mode.
         return false;
 
@@ -291,6 +359,7 @@ static inline bool check_triggers(RISCVCPUState *s, target_ulong t_mctl, target_
      * precompute the mask and pattern to lower some of the
      * cost). */
     t_mctl |= MCONTROL_U << s->priv;
+    CPU_FIELD_HIT(s, tdata1[0]);
 
     for (int i = 0; i < MAX_TRIGGERS; ++i)
         if ((s->tdata1[i] & t_mctl) == t_mctl) {
@@ -352,6 +421,7 @@ PHYS_MEM_READ_WRITE(64, uint64_t)
 
 /* return 0 if OK, != 0 if exception */
 #define TARGET_READ_WRITE(size, uint_type, size_log2)                                                                       \
+    template <bool FFWD = false>                                                                                            \
     static inline __must_use_result int target_read_u##size(RISCVCPUState *s, uint_type *pval, target_ulong addr) {         \
         if (check_triggers(s, MCONTROL_LOAD, addr))                                                                         \
             return -1;                                                                                                      \
@@ -362,10 +432,11 @@ PHYS_MEM_READ_WRITE(64, uint64_t)
             return -1;                                                                                                      \
         }                                                                                                                   \
         tlb_idx = (addr >> PG_SHIFT) & (TLB_SIZE - 1);                                                                      \
+        CPU_FIELD_HIT(s, tlb_read[tlb_idx]);                                                                                \
         if (likely(s->tlb_read[tlb_idx].vaddr == (addr & ~(PG_MASK & ~((size / 8) - 1))))) {                                \
             uint64_t data  = *(uint_type *)(s->tlb_read[tlb_idx].mem_addend + (uintptr_t)addr);                             \
             uint64_t paddr = s->tlb_read_paddr_addend[tlb_idx] + addr;                                                      \
-            *pval          = track_dread(s, addr, paddr, data, size,true);                                                       \
+            *pval          = track_dread<FFWD>(s, addr, paddr, data, size,true);                                            \
             return 0;                                                                                                       \
         }                                                                                                                   \
                                                                                                                             \
@@ -377,6 +448,7 @@ PHYS_MEM_READ_WRITE(64, uint64_t)
         return 0;                                                                                                           \
     }                                                                                                                       \
                                                                                                                             \
+    template <bool FFWD = false>                                                                                            \
     static inline __must_use_result int target_write_u##size(RISCVCPUState *s, target_ulong addr, uint_type val) {          \
                                                                                                                             \
         if (check_triggers(s, MCONTROL_STORE, addr))                                                                        \
@@ -389,13 +461,14 @@ PHYS_MEM_READ_WRITE(64, uint64_t)
         }                                                                                                                   \
                                                                                                                             \
         uint32_t tlb_idx = (addr >> PG_SHIFT) & (TLB_SIZE - 1);                                                             \
+        CPU_FIELD_HIT(s, tlb_write[tlb_idx]);                                                                               \
         if (likely(s->tlb_write[tlb_idx].vaddr == (addr & ~(PG_MASK & ~((size / 8) - 1))))) {                               \
             *(uint_type *)(s->tlb_write[tlb_idx].mem_addend + (uintptr_t)addr) = val;                                       \
                                                                                                                             \
             ++s->machine->memseqno;                                                                                         \
             ++s->load_res_memseqno;                                                                                         \
                                                                                                                             \
-            track_write(s, addr, s->tlb_write_paddr_addend[tlb_idx] + addr, val, size,true);                                     \
+            track_write<FFWD>(s, addr, s->tlb_write_paddr_addend[tlb_idx] + addr, val, size,true);                          \
             return 0;                                                                                                       \
         }                                                                                                                   \
                                                                                                                             \
@@ -949,13 +1022,27 @@ static inline target_ulong get_sew(RISCVCPUState *s) {
     return 1 << vsew + 3;
 }
 
+/* VLEN of the kernel set, a constant in the specialized ones */
+template <unsigned VL>
+static inline int vlen_of(RISCVCPUState *s) {
+    return VL ? VL : s->vlen;
+}
+
+/* Byte of a register group. The rows are contiguous, byte may run past
+ * the end of reg */
+template <unsigned VL>
+static inline uint8_t *v_elm(RISCVCPUState *s, int reg, int byte) {
+    return s->v_reg[0] + reg * (vlen_of<VL>(s) / 8) + byte;
+}
+
+template <unsigned VL = 0>
 static inline target_ulong get_vlmax(RISCVCPUState *s) {
     target_ulong vlmul = s->vtype & LMUL_MASK;
     if (vlmul & LMUL_BOUNDARY) {
         vlmul -= LMUL_BOUNDARY;
-        return VLEN / get_sew(s) / (16 >> vlmul);
+        return vlen_of<VL>(s) / get_sew(s) / (16 >> vlmul);
     }
-    return (1 << vlmul) * VLEN / get_sew(s);
+    return (1 << vlmul) * vlen_of<VL>(s) / get_sew(s);
 }
 
 // returns true if i bit of v0 mask reg is high
@@ -965,6 +1052,89 @@ static inline bool v0_mask(RISCVCPUState *s) {
     return val & 1;
 }
 
+/* true when a trigger could fire on accesses of type t_mctl, as in check_triggers */
+static inline bool triggers_armed(RISCVCPUState *s, target_ulong t_mctl) {
+    if (s->debug_mode)
+        return false;
+    t_mctl |= MCONTROL_U << s->priv;
+    for (int i = 0; i < MAX_TRIGGERS; ++i)
+        if ((s->tdata1[i] & t_mctl) == t_mctl)
+            return true;
+    return false;
+}
+
+/* Contiguous elements of a unit-stride access: the bytes of [addr,
+ * addr + n) in the page of addr, copied through the TLB in one go.
+ * Returns the bytes done, 0 when addr is misaligned or misses the TLB.
+ * The element path then takes the next element, it fills the TLB or
+ * traps, so faults land on the same element as before */
+static int vmem_block(RISCVCPUState *s, bool ld, target_ulong addr, uint8_t *v, int n, int eb) {
+    if (addr & (eb - 1))
+        return 0;
+    if ((target_ulong)n > PG_MASK + 1 - (addr & PG_MASK))
+        n = PG_MASK + 1 - (addr & PG_MASK);
+
+    uint32_t     tlb_idx = (addr >> PG_SHIFT) & (TLB_SIZE - 1);
+    target_ulong page    = addr & ~PG_MASK;
+    if (ld) {
+        if (s->tlb_read[tlb_idx].vaddr != page)
+            return 0;
+        memcpy(v, (uint8_t *)(s->tlb_read[tlb_idx].mem_addend + (uintptr_t)addr), n);
+        track_block(s, true, addr, s->tlb_read_paddr_addend[tlb_idx] + addr, v, n, eb);
+    } else {
+        if (s->tlb_write[tlb_idx].vaddr != page)
+            return 0;
+        memcpy((uint8_t *)(s->tlb_write[tlb_idx].mem_addend + (uintptr_t)addr), v, n);
+        s->machine->memseqno += n / eb;
+        s->load_res_memseqno += n / eb;
+        track_block(s, false, addr, s->tlb_write_paddr_addend[tlb_idx] + addr, v, n, eb);
+    }
+    return n;
+}
+
+/* The host page of the last element of a strided or indexed access */
+struct VmemPage {
+    target_ulong page         = (target_ulong)-1;
+    uintptr_t    mem_addend   = 0;
+    target_ulong paddr_addend = 0;
+};
+
+/* One element of a strided or indexed access through pg, so elements that
+ * fall in the same page look up the TLB once. Returns false when addr is
+ * misaligned or misses the TLB, the element path then fills it or traps
+ * and pg is dropped */
+static inline bool vmem_elm(RISCVCPUState *s, bool ld, VmemPage &pg, target_ulong addr, uint8_t *v, int eb) {
+    if (addr & (eb - 1))
+        return false;
+
+    target_ulong page = addr & ~PG_MASK;
+    if (page != pg.page) {
+        uint32_t tlb_idx = (addr >> PG_SHIFT) & (TLB_SIZE - 1);
+        if (ld) {
+            if (s->tlb_read[tlb_idx].vaddr != page)
+                return false;
+            pg.mem_addend   = s->tlb_read[tlb_idx].mem_addend;
+            pg.paddr_addend = s->tlb_read_paddr_addend[tlb_idx];
+        } else {
+            if (s->tlb_write[tlb_idx].vaddr != page)
+                return false;
+            pg.mem_addend   = s->tlb_write[tlb_idx].mem_addend;
+            pg.paddr_addend = s->tlb_write_paddr_addend[tlb_idx];
+        }
+        pg.page = page;
+    }
+
+    if (ld) {
+        memcpy(v, (uint8_t *)(pg.mem_addend + (uintptr_t)addr), eb);
+    } else {
+        memcpy((uint8_t *)(pg.mem_addend + (uintptr_t)addr), v, eb);
+        ++s->machine->memseqno;
+        ++s->load_res_memseqno;
+    }
+    track_block(s, ld, addr, pg.paddr_addend + addr, v, eb, eb);
+    return true;
+}
+
 V_REG_ACCESS_CONFIG(v_reg_read, V_REG_READ)
 V_MEM_OP_CONFIG(v_load, V_LOAD)
 V_MEM_OP_CONFIG(v_store, V_STORE)
@@ -974,9 +1144,11 @@ V_MEM_OP_CONFIG(v_store, V_STORE)
  * returns 1 if illegal insn
  * returns 2 if other exception
  */
-static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op (*vmem_op_config)(uint8_t)) {
-    int eew;
-    int vlmax = get_vlmax(s);
+template <unsigned VL>
+static int vmem_op_vl(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op (*vmem_op_config)(uint8_t)) {
+    const int vlen = vlen_of<VL>(s);
+    int       eew;
+    int       vlmax = get_vlmax<VL>(s);
     int width = insn >> 12 & 0x7;
 
     switch (width) {
@@ -988,12 +1160,12 @@ static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op
     }
 
     int byte_advance       = eew / 8;
-    int vec_size           = VLEN / eew, index_vec_size = 0;
+    int vec_size           = vlen / eew, index_vec_size = 0;
     Vector_Reg_Access read_vreg = NULL;
     int               i, j, k;
     int               mem_advance = 0, vs2_emul, index_vstart = 0;
     bool              fault_first = false, vector_indexed = false;
-    int               emul = 8 * vlmax * eew / VLEN;  // scaled up by 8 to avoid using floats
+    int               emul = 8 * vlmax * eew / vlen;  // scaled up by 8 to avoid using floats
     int               rd   = insn >> 7 & 0x1F;
     int               rs1  = insn >> 15 & 0x1F;
     int               rs2  = insn >> 20 & 0x1F;
@@ -1055,10 +1227,10 @@ static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op
 
             vector_indexed = true;
             read_vreg      = v_reg_read_config(eew);
-            index_vstart   = rs2 * VLEN / eew + s->vstart;
+            index_vstart   = rs2 * vlen / eew + s->vstart;
             byte_advance   = get_sew(s) / 8;
-            vec_size       = VLEN / get_sew(s);
-            index_vec_size = VLEN / eew;
+            vec_size       = vlen / get_sew(s);
+            index_vec_size = vlen / eew;
             break;
     }
     if ((emul == 0 || emul > 64) ||                     // out of range EMUL [1/8 : 8] is reserved
@@ -1080,6 +1252,18 @@ static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op
             return 2;
     }
 
+    /* unmasked single field accesses of contiguous elements, unit-stride
+     * or a stride of one element, go through vmem_block, other elements
+     * through vmem_elm. Both skip the per element trigger checks */
+    bool     direct = !triggers_armed(s, ld ? MCONTROL_LOAD : MCONTROL_STORE);
+    bool     block  = direct && !vector_indexed && vm && nf == 1 && mem_advance == byte_advance;
+    VmemPage pg;
+
+    /* vlse with rs2=x0 loads the first active element once and copies it
+     * to the others, the spec allows fewer memory operations there */
+    bool     bcast     = ld && mop == 2 && rs2 == 0 && nf == 1;
+    uint8_t *bcast_elm = NULL;
+
     int scaled_emul = emul < 8 ? 1 : emul / 8;
     if (ld)  // Register vregs prepared for insn
         for (i = 0; i < scaled_emul; i++)
@@ -1093,40 +1277,61 @@ static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op
         if (elm_start < vec_size) {                // segments expected to load for this vreg field
             target_ulong addr = read_reg(rs1);
             if (!vector_indexed)
-                addr += (elm_start * mem_advance) + (nf * i * VLEN / 8);
+                addr += (elm_start * mem_advance) + (nf * i * vlen / 8);
             elm_start *= byte_advance;             // scale to size
             int vec_size_scaled = vec_size * byte_advance;
 
             for (j = elm_start; j < vec_size_scaled; j += byte_advance) {
+                if (block) {
+                    int n = vmem_block(s, ld, addr, v_elm<VL>(s, rd + i, j), vec_size_scaled - j, byte_advance);
+                    if (n) {
+                        addr += n;
+                        s->vstart += n / byte_advance;
+                        j += n - byte_advance;
+                        continue;
+                    }
+                }
                 for (k = 0; k <= nf - 1; k++) {    // store each member of segment
                     if (vector_indexed) {
                         int index_vec = index_vstart / index_vec_size;
                         int index_elm = index_vstart % index_vec_size;
                         if (vm || v0_mask(s)) {
-                            if ((*v_op)(s, addr + read_vreg(s, index_vec, index_elm) + (k * byte_advance),
-                                &s->v_reg[rd + i + k * scaled_emul][j]))
+                            target_ulong a = addr + read_vreg(s, index_vec, index_elm) + (k * byte_advance);
+                            uint8_t     *v = v_elm<VL>(s, rd + i + k * scaled_emul, j);
+                            if (!(direct && vmem_elm(s, ld, pg, a, v, byte_advance))) {
+                                pg = VmemPage();
+                                if ((*v_op)(s, a, v))
                                     return 2;
+                            }
                         }
 #ifdef MASK_AGNOSTIC_FILL
                         else if (ld)
-                            mask_agnostic_fill(s, get_sew(s), &s->v_reg[rd + i + k * scaled_emul][j]);
+                            mask_agnostic_fill(s, get_sew(s), v_elm<VL>(s, rd + i + k * scaled_emul, j));
 #endif
                     } else {
                         if (vm || v0_mask(s)) {
-                            if ((*v_op)(s, addr, &s->v_reg[rd + i + (k * (nf - 1))][j]))
-                                if (!fault_first)      // fault can happen at any point
-                                    return 2;          // memory access caused exception
-                                else {                 // fault-only-first
-                                    s->vl                = s->vstart;
-                                    s->pending_tval      = 0;
-                                    s->pending_exception = -1;
-                                    s->vstart            = 0;
-                                    return 0;
-                                }
+                            uint8_t *v = v_elm<VL>(s, rd + i + (k * (nf - 1)), j);
+                            if (bcast_elm)
+                                memcpy(v, bcast_elm, byte_advance);
+                            else if (!(direct && vmem_elm(s, ld, pg, addr, v, byte_advance))) {
+                                pg = VmemPage();
+                                if ((*v_op)(s, addr, v))
+                                    if (!fault_first)      // fault can happen at any point
+                                        return 2;          // memory access caused exception
+                                    else {                 // fault-only-first
+                                        s->vl                = s->vstart;
+                                        s->pending_tval      = 0;
+                                        s->pending_exception = -1;
+                                        s->vstart            = 0;
+                                        return 0;
+                                    }
+                            }
+                            if (bcast)
+                                bcast_elm = v;
                         }
 #ifdef MASK_AGNOSTIC_FILL
                         else if (ld)
-                            mask_agnostic_fill(s, eew, &s->v_reg[rd + i + (k * (nf - 1))][j]);
+                            mask_agnostic_fill(s, eew, v_elm<VL>(s, rd + i + (k * (nf - 1)), j));
 #endif
                         addr += mem_advance;
                     }
@@ -1140,8 +1345,49 @@ static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op
     return 0;
 }
 
-bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulong vs1, uint8_t width_config, bool vv, bool vm,
-                          Vector_Integer_Op (*v_op_config)(uint8_t)) {
+/* Whole group kernels of the element ops that have one */
+static const struct {
+    Vector_Integer_Op (*v_op_config)(uint8_t);
+    Vector_Group_Op (*group_config)(uint8_t, bool, bool);
+} vector_group_ops[] = {
+    {v_add_config, vg_add_config<false, 1, 1>},
+    {vw_addu_config, vg_add_config<false, 2, 1>},
+    {vw_add_config, vg_add_config<true, 2, 1>},
+    {vw_adduw_config, vg_add_config<false, 2, 2>},
+    {vw_addw_config, vg_add_config<true, 2, 2>},
+};
+
+static Vector_Group_Op vector_group_op(Vector_Integer_Op (*v_op_config)(uint8_t), int sew, bool vv, bool vm) {
+    for (auto &op : vector_group_ops)
+        if (op.v_op_config == v_op_config)
+            return op.group_config(sew, vv, vm);
+    return NULL;
+}
+
+/* vregs [a, a + na) and [b, b + nb) share a register */
+static inline bool v_groups_overlap(int a, int na, int b, int nb) { return a < b + nb && b < a + na; }
+
+/* The group kernels give the element loop results unless those depend on
+ * the element order: masked ops writing v0 and widening ops with a narrow
+ * source overlapping vd. Fractional LMUL widening ops also stay on the
+ * element loop. lmul_scaled is that of vd */
+static bool vector_group_ok(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulong vs1, uint8_t width_config, bool vv,
+                            bool vm, int lmul_scaled) {
+    if (!vm && vd == 0)
+        return false;
+    if (width_config == SINGLE_WIDTH)
+        return true;
+    if (get_lmul(s) < 8)
+        return false;
+    if (width_config == WIDEN_VD && v_groups_overlap(vd, lmul_scaled, vs2, lmul_scaled / 2))
+        return false;
+    return !(vv && v_groups_overlap(vd, lmul_scaled, vs1, lmul_scaled / 2));
+}
+
+template <unsigned VL>
+static bool vectorize_arithmetic_vl(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulong vs1, uint8_t width_config, bool vv,
+                                    bool vm, Vector_Integer_Op (*v_op_config)(uint8_t)) {
+    const int vlen = vlen_of<VL>(s);
     if (s->vtype == VILL)
         return true;
 
@@ -1176,10 +1422,23 @@ bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulon
                 break;
         }
     }
+    int vec_size = vlen / sew;
+
+    /* whole group kernel, one call for all elements */
+#ifndef MASK_AGNOSTIC_FILL
+    Vector_Group_Op g_op = vector_group_op(v_op_config, get_sew(s), vv, vm);
+    if (g_op && vector_group_ok(s, vs2, vd, vs1, width_config, vv, vm, lmul_scaled)) {
+        for (int i = s->vstart / vec_size; i < lmul_scaled; i++) s->most_recently_written_vregs[vd + i] = true;
+        (*g_op)(v_elm<VL>(s, vd, 0), v_elm<VL>(s, vs2, 0), vv ? v_elm<VL>(s, vs1, 0) : NULL, vs1, vm ? NULL : s->v_reg[0],
+                s->vstart, lmul_scaled * vec_size);
+        s->vstart = 0;
+        return false;
+    }
+#endif
+
     uint8_t *vs2_ptr;
     void *   vs1_ptr      = &vs1;  // precalculate vs1 value if not vv operation
     int      byte_advance = sew / 8;
-    int      vec_size     = VLEN / sew;
     int      vs2_mod, vs1_mod, vs2_elm_mod, vs1_elm_mod;  // narrowing/widening modifiers set vs2/vs1 relative to vd
     vs2_mod = vs1_mod = vs2_elm_mod = vs1_elm_mod = 0;
     for (int i = 0; i < lmul_scaled; i++) {        // lmul/sew are relative to vd
@@ -1188,7 +1447,7 @@ bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulon
         if (elm_start < vec_size) {                         // operations expected to happen for this vreg
             s->most_recently_written_vregs[vd + i] = true;  // register vd(s) prepared for insn
             elm_start *= byte_advance;                      // scale to size
-            int vec_size_scaled = VLEN / 8;
+            int vec_size_scaled = vlen / 8;
 
             for (int j = elm_start; j < vec_size_scaled; j += byte_advance) {
                 if (width_config)
@@ -1212,14 +1471,14 @@ bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulon
                     }
 
                 if (vv)  // vector-vector operation
-                    vs1_ptr = &s->v_reg[vs1 + i + vs1_mod][j + vs1_elm_mod];
-                vs2_ptr = &s->v_reg[vs2 + i + vs2_mod][j + vs2_elm_mod];
+                    vs1_ptr = v_elm<VL>(s, vs1 + i + vs1_mod, j + vs1_elm_mod);
+                vs2_ptr = v_elm<VL>(s, vs2 + i + vs2_mod, j + vs2_elm_mod);
 
                 if (vm || v0_mask(s))
-                    (*v_op)(s, &s->v_reg[vd + i][j], vs2_ptr, vs1_ptr);
+                    (*v_op)(s, v_elm<VL>(s, vd + i, j), vs2_ptr, vs1_ptr);
 #ifdef MASK_AGNOSTIC_FILL
                 else
-                    mask_agnostic_fill(s, sew, &s->v_reg[vd + i][j]);
+                    mask_agnostic_fill(s, sew, v_elm<VL>(s, vd + i, j));
 #endif
                 s->vstart++;
             }
@@ -1228,6 +1487,37 @@ bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulon
     s->vstart = 0;
     return false;
 }
+
+template <unsigned VL>
+static const RISCVVectorKernels vector_kernels_vl = {VL, &vmem_op_vl<VL>, &vectorize_arithmetic_vl<VL>};
+
+/* Widths with a kernel set of their own, anything else uses the runtime one */
+static const RISCVVectorKernels *const vector_kernels[] = {
+    &vector_kernels_vl<128>,
+    &vector_kernels_vl<256>,
+    &vector_kernels_vl<512>,
+};
+
+static const RISCVVectorKernels *riscv_vector_kernels(uint32_t vlen) {
+    for (auto k : vector_kernels)
+        if (k->vlen == vlen)
+            return k;
+    return &vector_kernels_vl<0>;
+}
+
+static inline int vmem_op(RISCVCPUState *s, int insn, bool ld, Vector_Memory_Op (*vmem_op_config)(uint8_t)) {
+    return s->vk->mem_op(s, insn, ld, vmem_op_config);
+}
+
+bool vectorize_arithmetic(RISCVCPUState *s, uint8_t vs2, uint8_t vd, target_ulong vs1, uint8_t width_config, bool vv, bool vm,
+                          Vector_Integer_Op (*v_op_config)(uint8_t)) {
+    return s->vk->arithmetic(s, vs2, vd, vs1, width_config, vv, vm, v_op_config);
+}
+
+/* VLEN is a power of 2 from ELEN to VLEN_MAX, ELEN one of 8..64 */
+bool riscv_vector_config_ok(uint32_t vlen, uint32_t elen) {
+    return IS_PO2(elen) && ELEN_MIN <= elen && elen <= 64 && IS_PO2(vlen) && elen <= vlen && vlen <= VLEN_MAX;
+}
 #endif
 
 #define SSTATUS_MASK (MSTATUS_SIE | MSTATUS_SPIE | MSTATUS_SPP | MSTATUS_VS | MSTATUS_FS | MSTATUS_SUM | MSTATUS_MXR | MSTATUS_UXL_MASK)
@@ -1255,7 +1545,7 @@ static void set_mstatus(RISCVCPUState *s, target_ulong val) {
         tlb_flush_all(s);
     }
     s->fs = (val >> MSTATUS_FS_SHIFT) & 3;
-    s->vs = (val >> MSTATUS_VS_SHIFT) & 3;
+    s->vs = (s->misa & MCPUID_V) ? (val >> MSTATUS_VS_SHIFT) & 3 : 0;
 
     target_ulong mask = MSTATUS_MASK & ~(MSTATUS_FS | MSTATUS_VS | MSTATUS_UXL_MASK | MSTATUS_SXL_MASK);
     s->mstatus        = s->mstatus & ~mask | val & mask;
@@ -1484,7 +1774,7 @@ static int csr_read(RISCVCPUState *s, uint32_t funct3,
         case 0xc22: /* vlenb */
             if (s->vs == 0)
                 return -1;
-            val = VLEN / 8; /* The value in vlenb is a design-time constant in any implementation */
+            val = s->vlen / 8; /* The value in vlenb is a design-time constant in any implementation */
             break;
 #endif
         case 0xf14: val = s->mhartid; break;
@@ -1567,8 +1857,10 @@ static void set_frm(RISCVCPUState *s, unsigned int val) { s->frm = val; }
 
 /* return -1 if invalid roundind mode */
 static int get_insn_rm(RISCVCPUState *s, unsigned int rm) {
-    if (rm == 7)
+    if (rm == 7) {
+        CPU_FIELD_HIT(s, frm);
         rm = s->frm;
+    }
 
     if (rm >= 5)
         return -1;
@@ -1667,7 +1959,7 @@ static int csr_write(RISCVCPUState *s, uint32_t funct3, uint32_t csr, target_ulo
         case 0x008: /* vstart */
             if (s->vs == 0)
                 return -1;
-            s->vstart = val & VSTART_MASK;
+            s->vstart = val & VSTART_MASK(s);
             s->vs     = 3;
             break;
         case 0x009: /* vxsat */
@@ -2218,18 +2510,29 @@ static inline RISCVCTFInfo ctf_compute_hint(int rd, int rs1) {
 
 /*
  * While the 32-bit QNAN is defined in softfp.h, we need it here to
- * pull f_unbox{32,64} out of the fragile macro magic.
+ * pull f_unbox{32,64,128} out of the fragile macro magic.
  */
 static const sfloat64 f_qnan32 = 0x7fc00000;
+static const sfloat64 f_qnan64 = 0x7ff8000000000000;
 
-static sfloat64 f_unbox32(sfloat64 r) {
+static fp_uint f_unbox32(fp_uint r) {
     if ((r & F32_HIGH) != F32_HIGH)
         return f_qnan32;
 
     return r;
 }
 
-static sfloat64 f_unbox64(sfloat64 r) { return r; }
+static fp_uint f_unbox64(fp_uint r) {
+#if FLEN > 64
+    if ((r & F64_HIGH) != F64_HIGH)
+        return f_qnan64;
+#endif
+    return r;
+}
+
+#if FLEN > 64
+static fp_uint f_unbox128(fp_uint r) { return r; }
+#endif
 
 //#define XLEN 32
 //#include "majordomo_template.h"
@@ -2256,7 +2559,8 @@ uint32_t riscv_cpu_get_mip(RISCVCPUState *s) { return s->mip; }
 BOOL riscv_cpu_get_power_down(RISCVCPUState *s) { return s->power_down_flag; }
 
 RISCVCPUState *riscv_cpu_init(RISCVMachine *machine, int hartid) {
-    RISCVCPUState *s   = (RISCVCPUState *)mallocz(sizeof *s);
+    RISCVCPUState *s   = (RISCVCPUState *)aligned_alloc(alignof(RISCVCPUState), sizeof *s);
+    memset((void *)s, 0, sizeof *s);
     s->machine         = machine;
     s->mem_map         = machine->mem_map;
     s->pc              = machine->reset_vector;
@@ -2276,11 +2580,21 @@ RISCVCPUState *riscv_cpu_init(RISCVMachine *machine, int hartid) {
 #if FLEN >= 128
     s->misa |= MCPUID_Q;
 #endif
+    s->interp = &riscv_interp_profiles64[machine->isa_profile];
+    uint32_t isa_ext = machine->isa_ext;
 #if VLEN > 0
     clear_most_recently_written_vregs(s);
-    s->misa |= MCPUID_V;
+    if (isa_ext & ISA_EXT_V)
+        s->misa |= MCPUID_V;
+
+    s->vlen             = machine->vlen;
+    s->elen             = machine->elen;
+    s->vk               = riscv_vector_kernels(s->vlen);
+    uint8_t *v_reg_file = (uint8_t *)mallocz(32 * s->vlen / 8);
+    for (int i = 0; i < 32; ++i) s->v_reg[i] = v_reg_file + i * s->vlen / 8;
 #endif
-    s->misa |= MCPUID_C;
+    if (isa_ext & ISA_EXT_C)
+        s->misa |= MCPUID_C;
 
     if (machine->custom_extension)
         s->misa |= MCPUID_X;
@@ -2312,7 +2626,73 @@ RISCVCPUState *riscv_cpu_init(RISCVMachine *machine, int hartid) {
     return s;
 }
 
-void riscv_cpu_end(RISCVCPUState *s) { free(s); }
+#ifdef CPU_FIELD_STATS
+uint64_t cpu_field_hits[sizeof(RISCVCPUState) / 8];
+#endif
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#define CPU_FIELD(f) {#f, offsetof(RISCVCPUState, f), sizeof(RISCVCPUState::f)}
+
+static const struct {
+    const char *name;
+    size_t      offset, size;
+} cpu_fields[] = {
+    CPU_FIELD(pc), CPU_FIELD(last_pc), CPU_FIELD(machine), CPU_FIELD(insn_counter),
+    CPU_FIELD(most_recently_written_reg), CPU_FIELD(pending_exception), CPU_FIELD(pending_tval),
+    CPU_FIELD(priv), CPU_FIELD(fs), CPU_FIELD(vs),
+#if FLEN > 0
+    CPU_FIELD(frm), CPU_FIELD(fflags), CPU_FIELD(most_recently_written_fp_reg),
+#endif
+    CPU_FIELD(debug_mode), CPU_FIELD(info), CPU_FIELD(next_addr),
+    CPU_FIELD(last_data_paddr), CPU_FIELD(last_data_vaddr), CPU_FIELD(last_data_size), CPU_FIELD(last_data_type),
+    CPU_FIELD(tdata1), CPU_FIELD(reg),
+#if FLEN > 0
+    CPU_FIELD(fp_reg),
+#endif
+    CPU_FIELD(reg_prior),
+    CPU_FIELD(mie), CPU_FIELD(mip), CPU_FIELD(mstatus), CPU_FIELD(load_res), CPU_FIELD(load_res_memseqno),
+    CPU_FIELD(interp),
+#if VLEN > 0
+    CPU_FIELD(v_reg), CPU_FIELD(most_recently_written_vregs), CPU_FIELD(vlen), CPU_FIELD(elen), CPU_FIELD(vk),
+    CPU_FIELD(vstart), CPU_FIELD(vxsat), CPU_FIELD(vxrm), CPU_FIELD(vtype), CPU_FIELD(vl),
+#endif
+    CPU_FIELD(tlb_read), CPU_FIELD(tlb_write), CPU_FIELD(tlb_code),
+#ifndef PADDR_INLINE
+    CPU_FIELD(tlb_read_paddr_addend), CPU_FIELD(tlb_write_paddr_addend), CPU_FIELD(tlb_code_paddr_addend),
+#endif
+    CPU_FIELD(mem_map), CPU_FIELD(minstret), CPU_FIELD(mcycle), CPU_FIELD(mtvec), CPU_FIELD(misa),
+    CPU_FIELD(tdata2), CPU_FIELD(mhpmevent), CPU_FIELD(csr_pmpaddr), CPU_FIELD(pmp), CPU_FIELD(satp),
+    CPU_FIELD(timecmp), CPU_FIELD(stf_read_regs), CPU_FIELD(stf_mem_writes), CPU_FIELD(stf_prev_priv_mode),
+};
+
+#undef CPU_FIELD
+#pragma GCC diagnostic pop
+
+void riscv_cpu_print_layout(FILE *f) {
+    fprintf(f, "RISCVCPUState: %zu bytes, %zu cache lines, hot part up to reg_prior\n", sizeof(RISCVCPUState),
+            (sizeof(RISCVCPUState) + 63) / 64);
+    fprintf(f, "  %8s %6s %5s %14s  %s\n", "offset", "size", "line", "accesses", "field");
+    for (const auto &fld : cpu_fields) {
+#ifdef CPU_FIELD_STATS
+        uint64_t hits = 0;
+        for (size_t w = fld.offset / 8; w < (fld.offset + fld.size + 7) / 8; ++w) hits += cpu_field_hits[w];
+        fprintf(f, "  %8zu %6zu %5zu %14" PRIu64 "  %s\n", fld.offset, fld.size, fld.offset / 64, hits, fld.name);
+#else
+        fprintf(f, "  %8zu %6zu %5zu %14s  %s\n", fld.offset, fld.size, fld.offset / 64, "-", fld.name);
+#endif
+    }
+#ifndef CPU_FIELD_STATS
+    fprintf(f, "  access counts need a CPU_FIELD_STATS build\n");
+#endif
+}
+
+void riscv_cpu_end(RISCVCPUState *s) {
+#if VLEN > 0
+    free(s->v_reg[0]);
+#endif
+    free(s);
+}
 
 void riscv_set_pc(RISCVCPUState *s, uint64_t val) { s->pc = val & (s->misa & MCPUID_C ? ~1 : ~3); }
 
@@ -2412,19 +2792,50 @@ BOOL riscv_terminated(RISCVCPUState *s) { return s->terminate_simulation; }
 
 void riscv_set_debug_mode(RISCVCPUState *s, bool on) { s->debug_mode = on; }
 
+static bool is_zero_block(const uint8_t *p, size_t size) {
+    const uint64_t *w = (const uint64_t *)p;
+    for (size_t i = 0; i < size / sizeof *w; ++i)
+        if (w[i]) return false;
+    return true;
+}
+
+// All-zero 4 KiB blocks are skipped, leaving holes in the file. Most of
+// a checkpointed RAM image is untouched, the holes read back as zeros.
 static void serialize_memory(const void *base, size_t size, const char *file) {
+    const size_t   block = 4096;
+    const uint8_t *p     = (const uint8_t *)base;
     int f_fd = open(file, O_CREAT | O_WRONLY | O_TRUNC, 0777);
 
     if (f_fd < 0)
         err(-3, "trying to write %s", file);
 
-    while (size) {
-        ssize_t written = write(f_fd, base, size);
-        if (written <= 0)
+    size_t pos = 0;
+    while (pos < size) {
+        size_t len = std::min(block, size - pos);
+        if (len == block && is_zero_block(p + pos, len)) {
+            pos += len;
+            continue;
+        }
+
+        // Extend the run over following non-zero blocks
+        size_t end = pos + len;
+        while (end < size && !(size - end >= block && is_zero_block(p + end, block)))
+            end += std::min(block, size - end);
+
+        if (lseek(f_fd, pos, SEEK_SET) < 0)
             err(-3, "while writing %s", file);
-        size -= written;
+
+        while (pos < end) {
+            ssize_t written = write(f_fd, p + pos, end - pos);
+            if (written <= 0)
+                err(-3, "while writing %s", file);
+            pos += written;
+        }
     }
 
+    if (ftruncate(f_fd, size) < 0)
+        err(-3, "while writing %s", file);
+
     close(f_fd);
 }
 
@@ -2453,12 +2864,15 @@ static uint32_t create_auipc(int rd, uint32_t addr) {
     return 0x17 | ((rd & 0x1F) << 7) | ((addr >> 12) << 12);
 }
 
-/*
- * Might use it one day, but GCC doesn't like unused static functions
- * static uint32_t create_lui(int rd, uint32_t addr) {
- *     return 0x37 | ((rd & 0x1F) << 7) | ((addr >> 12) << 12);
- * }
- */
+#ifdef LIVECACHE
+// Paired with create_addi, which sign extends the low 12 bits
+static uint32_t create_lui(int rd, uint32_t addr) {
+    if (addr & 0x800)
+        addr += 0x800;
+
+    return 0x37 | ((rd & 0x1F) << 7) | ((addr >> 12) << 12);
+}
+#endif
 
 static uint32_t create_addi(int rd, uint32_t addr) {
     uint32_t pos = addr & 0xFFF;
@@ -2480,72 +2894,54 @@ static void create_csr12_recovery(uint32_t *rom, uint32_t *code_pos, uint32_t cs
 }
 
 #ifdef LIVECACHE
-static void create_warmup_data(uint32_t *rom, uint32_t *data_pos, uint64_t addr) {
-    rom[(*data_pos)++] = addr & 0xFFFFFFFF;
-    rom[(*data_pos)++] = addr >> 32;
+static uint32_t create_itype(uint32_t opcode, uint32_t funct3, int rd, int rs1, int32_t imm) {
+    return opcode | ((rd & 0x1F) << 7) | (funct3 << 12) | ((rs1 & 0x1F) << 15) | (((uint32_t)imm & 0xFFF) << 20);
 }
 
-static void create_warmup_loop(uint32_t *rom, uint32_t *code_pos, uint32_t *data_pos, uint32_t warmup_size) {
-    uint32_t data_off = sizeof(uint32_t) * (*data_pos - *code_pos);
+static uint32_t create_beqz(int rs1, int32_t off) {
+    uint32_t imm = (uint32_t)off;
+    return 0x63 | (((imm >> 11) & 1) << 7) | (((imm >> 1) & 0xF) << 8) | ((rs1 & 0x1F) << 15) | (((imm >> 5) & 0x3F) << 25)
+           | (((imm >> 12) & 1) << 31);
+}
 
-// The warmup executes a loop very close to this (the total is not needed, but in C is needed to avoid dead-code-elimination.)
-//
-// int warmup_loop(long int *base, unsigned int base_size) {
-//   unsigned int total=0;
-//   for(unsigned int i=0;i<base_size;++i) {
-//     long int addr = base[i];
-//     char *ptr = (char *)addr; // OK to have 1 at LSB because we do LB/SB
-//     if (addr&1)
-//       *ptr = *ptr+1; // THIS IS TO AVOID elimination. should be *ptr+0
-//     else
-//       total += *ptr;
-//   }
-//
-//   return total;
-// }
-//
-// The assembly (without return at pointer check return)
-//
-    rom[(*code_pos)++] = create_auipc(10, data_off);  // s0 == data_pos (or begin of data trace
-    rom[(*code_pos)++] = create_addi(10, data_off);
-    rom[(*code_pos)++] = create_lui(11, warmup_size);
-    rom[(*code_pos)++] = create_addi(11, warmup_size);
-
-//   2: fff5869b                addiw   a3,a1,-1
-    rom[(*code_pos)++] = 0xfff5869b;
-//   6: 1682                slli        a3,a3,0x20
-//   8: 82f5                srli        a3,a3,0x1d
-    rom[(*code_pos)++] = 0x82f51682;
-//   a: 00850793                addi    a5,a0,8
-    rom[(*code_pos)++] = 0x00850793;
-//   e: 96be                add a3,a3,a5
-//  10: 4581                li  a1,0
-    rom[(*code_pos)++] = 0x458196be;
-//  12: a039                j   20 <.L5>
-//
-//  14: 2701                addiw       a4,a4,1 // FIXED to a4,a4,0
-    rom[(*code_pos)++] = 0x2701a039;
-//  16: 00e78023                sb      a4,0(a5)
-    rom[(*code_pos)++] = 0x00e78023;
-//  1a: 0521                addi        a0,a0,8
-//  1c: 00d50c63                beq     a0,a3,34 <.L9>
-    rom[(*code_pos)++] = 0x0c630521;
-//
-//  20: 611c                ld  a5,0(a0)
-    rom[(*code_pos)++] = 0x611c00d5;
-//  22: 0017f613                andi    a2,a5,1
-    rom[(*code_pos)++] = 0x0017f613;
-//  26: 0007c703                lbu     a4,0(a5)
-    rom[(*code_pos)++] = 0x0007c703;
-//  2a: f66d                bnez        a2,14 <.L10>
-//  2c: 0521                addi        a0,a0,8
-    rom[(*code_pos)++] = 0x0521f66d;
-//  2e: 9db9                addw        a1,a1,a4
-//  30: fed518e3                bne     a0,a3,20 <.L5>
-    rom[(*code_pos)++] = 0x18e39db9;
-//  34: 4501                li  a0,0 // A 2 byte NOP to have 4 bytes alignment
-    rom[(*code_pos)++] = 0x4501fed5;
+static uint32_t create_j(int32_t off) {
+    uint32_t imm = (uint32_t)off;
+    return 0x6f | (((imm >> 12) & 0xFF) << 12) | (((imm >> 11) & 1) << 20) | (((imm >> 1) & 0x3FF) << 21)
+           | (((imm >> 20) & 1) << 31);
+}
 
+// Replay the warm set from the region at WARMUP_BASE_ADDR, mapped and
+// filled by the restore (see majordomo_warmup.h). A zero count, as written
+// when the warm set is pre-loaded instead, skips the loop.
+//
+//         li    a0, WARMUP_BASE_ADDR
+//         ld    a1, 0(a0)
+//         addi  a0, a0, 8
+//   loop: beqz  a1, done
+//         ld    a5, 0(a0)
+//         andi  a2, a5, 1
+//         lbu   a4, 0(a5)     // OK to have 1 at LSB because we do LB/SB
+//         beqz  a2, next
+//         sb    a4, 0(a5)
+//   next: addi  a0, a0, 8
+//         addi  a1, a1, -1
+//         j     loop
+//   done:
+static void create_warmup_loop(uint32_t *rom, uint32_t *code_pos) {
+    rom[(*code_pos)++] = create_lui(10, WARMUP_BASE_ADDR);
+    rom[(*code_pos)++] = create_addi(10, WARMUP_BASE_ADDR);
+    rom[(*code_pos)++] = create_ld(11, 10);
+    rom[(*code_pos)++] = create_addi(10, 8);
+
+    rom[(*code_pos)++] = create_beqz(11, 9 * 4);
+    rom[(*code_pos)++] = create_ld(15, 10);
+    rom[(*code_pos)++] = create_itype(0x13, 7, 12, 15, 1);  // andi
+    rom[(*code_pos)++] = create_itype(0x03, 4, 14, 15, 0);  // lbu
+    rom[(*code_pos)++] = create_beqz(12, 2 * 4);
+    rom[(*code_pos)++] = 0x23 | (15 << 15) | (14 << 20);    // sb
+    rom[(*code_pos)++] = create_addi(10, 8);
+    rom[(*code_pos)++] = create_addi(11, -1);
+    rom[(*code_pos)++] = create_j(-8 * 4);
 }
 #endif
 
@@ -2634,22 +3030,7 @@ static void create_boot_rom(RISCVCPUState *s, const char *file, const uint64_t c
     create_csr12_recovery(rom, &code_pos, 0x7b0, 0x600 | s->priv);
 
 #ifdef LIVECACHE
-    uint64_t  n_addr=0;
-    uint64_t  n_addr_to_skip=0;
-    uint64_t *addr = s->machine->llc->traverse(n_addr);
-
-    if (n_addr > (ROM_SIZE-1024)) {
-        fprintf(stderr, "LiveCache: truncating boot rom from %d to %d (you may want to increase ROM_SIZE for better warmup)\n", n_addr, ROM_SIZE-1024);
-        n_addr_to_skip = n_addr - (ROM_SIZE - 1024);
-    }
-    uint32_t n_entries = n_addr-n_addr_to_skip;
-
-    create_warmup_loop(rom, &code_pos, &data_pos, n_entries);
-    for (size_t i = n_addr_to_skip; i < n_addr; ++i) {
-        uint64_t a = addr[i] & ~0x1ULL;
-        printf("addr:%llx %s\n", (unsigned long long)a, (addr[i] & 1) ? "ST" : "LD");
-        create_warmup_data(rom, &data_pos, addr[i]);
-    }
+    create_warmup_loop(rom, &code_pos);
 #endif
 
     // NOTE: mstatus & misa should be one of the first because risvemu breaks down this
@@ -2841,6 +3222,8 @@ void riscv_cpu_serialize(RISCVCPUState *s, const char *dump_name, const uint64_t
         }
     }
 
+    fclose(conf_fd);
+
     if (!boot_ram || !main_ram_found) {
         fprintf(majordomo_stderr, "ERROR: could not find boot and main ram???\n");
         exit(-3);
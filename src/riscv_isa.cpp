@@ -57,7 +57,9 @@ std::unordered_map<char,bool IsaConfigFlags::*> simpleExts = {
     {'a', &IsaConfigFlags::a},
     {'f', &IsaConfigFlags::f},
     {'d', &IsaConfigFlags::d},
-    {'c', &IsaConfigFlags::c}
+    {'c', &IsaConfigFlags::c},
+    {'b', &IsaConfigFlags::b},
+    {'v', &IsaConfigFlags::v}
 };
 
 std::unordered_map<std::string, bool IsaConfigFlags::*> extensionMap = {
@@ -69,30 +71,45 @@ std::unordered_map<std::string, bool IsaConfigFlags::*> extensionMap = {
     {"f", &IsaConfigFlags::f},
     {"d", &IsaConfigFlags::d},
     {"c", &IsaConfigFlags::c},
+    {"b", &IsaConfigFlags::b},
+    {"v", &IsaConfigFlags::v},
     {"zba", &IsaConfigFlags::zba},
     {"zbb", &IsaConfigFlags::zbb},
     {"zbc", &IsaConfigFlags::zbc},
     {"zbs", &IsaConfigFlags::zbs},
     {"zfh", &IsaConfigFlags::zfh},
-    {"zfa", &IsaConfigFlags::zfa}
+    {"zfa", &IsaConfigFlags::zfa},
+    {"zicond", &IsaConfigFlags::zicond}
 };
+
+const IsaProfile isa_profiles[] = {
+    {"rv64g",   "rv64g",               ISA_PROFILE_RV64G},
+    {"rv64gb",  "rv64gb",              ISA_PROFILE_RV64GB},
+    {"rv64gv",  "rv64gv",              ISA_PROFILE_RV64GV},
+    {"rv64gc",  "rv64gc",              ISA_PROFILE_RV64GC},
+    {"rv64gcb", "rv64gcb",             ISA_PROFILE_RV64GCB},
+    {"rv64gcv", "rv64gcv",             ISA_PROFILE_RV64GCV},
+    {"rva23",   "rv64gcbv_zicond",     ISA_PROFILE_RVA23},
+    {"all",     "rv64gcbv_zbc_zicond", ISA_PROFILE_ALL}
+};
+const int isa_num_profiles = sizeof(isa_profiles) / sizeof(isa_profiles[0]);
 // -----------------------------------------------------------------------
 // -----------------------------------------------------------------------
 void setIsaConfigFlags(const std::string& input, IsaConfigFlags& flags)
 {
-    // Iterate over each character for single-character extensions
-    for (char ch : input) {
-        std::string ext(1, ch);
-        if (extensionMap.find(ext) != extensionMap.end()) {
-            flags.*extensionMap[ext] = true;
-        }
-    }
-
-    // Iterate over each known multi-character extension
-    for (const auto& [key, _] : extensionMap) {
-        if (key.length() > 1 && input.find(key) != std::string::npos) {
-            flags.*extensionMap[key] = true;
-        }
+    // The single character extensions are in the initial segment, see
+    // validateInitialSegment, the multi-character ones follow, one per
+    // '_' separated token. Unknown tokens (zvl<N>b, ...) are skipped.
+    size_t pos = input.find('_');
+    while (pos != std::string::npos) {
+        size_t next = input.find('_', pos + 1);
+        std::string ext = input.substr(pos + 1, next == std::string::npos
+                                                ? std::string::npos
+                                                : next - pos - 1);
+        auto it = extensionMap.find(ext);
+        if (ext.length() > 1 && it != extensionMap.end())
+            flags.*(it->second) = true;
+        pos = next;
     }
 }
 // -----------------------------------------------------------------------
@@ -169,6 +186,10 @@ bool validateInitialSegment(const std::string& segment,IsaConfigFlags &flags)
               flags.a = true;
               flags.f = true;
               flags.d = true;
+            } else if(it->first == 'b') {
+              flags.zba = true;
+              flags.zbb = true;
+              flags.zbs = true;
             }
         } else {
             fprintf(majordomo_stderr,
@@ -183,8 +204,37 @@ bool validateInitialSegment(const std::string& segment,IsaConfigFlags &flags)
 // -----------------------------------------------------------------------
 bool parse_isa_string(const char *march,IsaConfigFlags &flags)
 {
+  // Only what the string names is enabled
+  for (const auto& [key, flagPtr] : extensionMap) flags.*flagPtr = false;
+
   //Message will be emitted by sub-functions
   if(!validateInitialSegment(std::string(march),flags)) return false;
   setIsaConfigFlags(std::string(march), flags);
   return true;
 }
+
+// -----------------------------------------------------------------------
+// The interpreter extension bits of a parsed --march
+// -----------------------------------------------------------------------
+uint32_t isa_config_ext(const IsaConfigFlags &flags)
+{
+  uint32_t ext = 0;
+  if (flags.c)      ext |= ISA_EXT_C;
+  if (flags.v)      ext |= ISA_EXT_V;
+  if (flags.zba)    ext |= ISA_EXT_ZBA;
+  if (flags.zbb)    ext |= ISA_EXT_ZBB;
+  if (flags.zbc)    ext |= ISA_EXT_ZBC;
+  if (flags.zbs)    ext |= ISA_EXT_ZBS;
+  if (flags.zicond) ext |= ISA_EXT_ZICOND;
+  return ext;
+}
+// -----------------------------------------------------------------------
+// The profile with exactly ext, -1 when there is none
+// -----------------------------------------------------------------------
+int isa_profile_index(uint32_t ext)
+{
+  for (int i = 0; i < isa_num_profiles; ++i) {
+    if (isa_profiles[i].ext == ext) return i;
+  }
+  return -1;
+}
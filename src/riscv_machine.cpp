@@ -43,6 +43,8 @@
 #include "majordomo_protos.h"
 #include "dw_apb_uart.h"
 #include "elf64.h"
+#include "majordomo_simpoint.h"
+#include "majordomo_warmup.h"
 #include "options.h"
 #include "riscv_machine.h"
 #include "termio.h"
@@ -52,8 +54,52 @@
 #include <cstdarg>
 #include <err.h>
 #include <getopt.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <vector>
 using namespace std;
 
+// Long only option codes, outside the char range used by the short codes
+enum {
+    OPT_SIMPOINT_ROI_AT_RESET = 256,
+    OPT_SIMPOINT_CLUSTER,
+    OPT_SIMPOINT_AUTO,
+    OPT_SIMPOINT_MAXK,
+    OPT_SIMPOINT_DIM,
+    OPT_SIMPOINT_THREADS,
+    OPT_SIMPOINT_OUT,
+    OPT_CHECKPOINT_ASYNC,
+    OPT_FAST_FORWARD,
+    OPT_FAST_FORWARD_PC,
+    OPT_STATS_FILE,
+    OPT_CPU_LAYOUT,
+    OPT_LIVE_CACHE_CONFIG,
+    OPT_WARMUP_RESTORE,
+    OPT_LIVE_CACHE_WINDOW,
+    OPT_VLEN,
+    OPT_ELEN,
+};
+
+#if VLEN > 0
+// zvl<N>b and zve32*/zve64* in an ISA string select VLEN and ELEN, the
+// largest zvl wins
+static void march_vector_config(const char *march, uint64_t *vlen, uint64_t *elen) {
+    uint64_t zvl = 0;
+    for (const char *q = strchr(march, 'z'); q; q = strchr(q + 1, 'z')) {
+        unsigned n;
+        char     b;
+        if (sscanf(q, "zvl%u%c", &n, &b) == 2 && b == 'b')
+            zvl = std::max<uint64_t>(zvl, n);
+        else if (sscanf(q, "zve%u", &n) == 1)
+            *elen = n;
+    }
+    if (zvl)
+        *vlen = zvl;
+}
+#endif
+
 RISCVMachine *virt_machine_main(int argc, char **argv) {
 
 //FIXME: full integration of boost options is in progress.
@@ -88,6 +134,19 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
     bool        simpoint_en_bbv            = false;
     const char *simpoint_bb_file           = nullptr;
     uint64_t    simpoint_size              = 100000000UL;
+    bool        simpoint_roi_at_reset      = false;
+    bool        simpoint_cluster           = false;
+    bool        simpoint_auto              = false;
+    int         simpoint_maxk              = 30;
+    int         simpoint_dim               = 15;
+    int         simpoint_threads           = 0;
+    const char *simpoint_out               = nullptr;
+    int         checkpoint_async           = -1;
+    bool        warmup_preload             = false;
+    uint64_t    ffwd_until_insns           = 0;
+    uint64_t    ffwd_until_pc              = UINT64_MAX;
+    const char *stats_file                 = nullptr;
+    bool        cpu_layout                 = false;
 
     long        memory_size_override      = 0;
     uint64_t    memory_addr_override      = 0;
@@ -107,12 +166,17 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
     bool        clear_ids                 = false;
 
 #ifdef LIVECACHE
-    uint64_t    live_cache_size            = 8*1024*1024;
+    uint64_t    live_cache_size            = 0;
+    const char *live_cache_config          = 0;
+    uint64_t    live_cache_window          = 0;
 #endif
     bool        elf_based                  = false;
     bool        allow_ctrlc                = false;
     bool        show_enabled_extensions    = false;
     const char *march_string               = "rv64gc";
+    bool        march_given                = false;
+    uint64_t    vlen                       = 0;
+    uint64_t    elen                       = 0;
 
     majordomo_stdout    = stdout;
     majordomo_stderr    = stderr;
@@ -140,6 +204,8 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
 
             {"march",                       required_argument, 0,  'i' },
             {"custom_extension",                  no_argument, 0,  'u' }, // CFG
+            {"vlen",                        required_argument, 0,  OPT_VLEN }, // CFG
+            {"elen",                        required_argument, 0,  OPT_ELEN }, // CFG
 
             {"trace",                       required_argument, 0,  't' },
             {"exe_trace",                   required_argument, 0,  'T' },
@@ -160,6 +226,19 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
             {"simpoint_en_bbv",                   no_argument, 0,  'v' },
             {"simpoint_bb_file",            required_argument, 0,  'F' },
             {"simpoint_size",               required_argument, 0,  'Y' }, // CFG
+            {"simpoint_roi_at_reset",             no_argument, 0,  OPT_SIMPOINT_ROI_AT_RESET },
+            {"simpoint_cluster",                  no_argument, 0,  OPT_SIMPOINT_CLUSTER },
+            {"simpoint_auto",                     no_argument, 0,  OPT_SIMPOINT_AUTO },
+            {"simpoint_maxk",               required_argument, 0,  OPT_SIMPOINT_MAXK },
+            {"simpoint_dim",                required_argument, 0,  OPT_SIMPOINT_DIM },
+            {"simpoint_threads",            required_argument, 0,  OPT_SIMPOINT_THREADS },
+            {"simpoint_out",                required_argument, 0,  OPT_SIMPOINT_OUT },
+            {"checkpoint_async",            required_argument, 0,  OPT_CHECKPOINT_ASYNC },
+            {"warmup_restore",              required_argument, 0,  OPT_WARMUP_RESTORE },
+            {"fast_forward",                required_argument, 0,  OPT_FAST_FORWARD },
+            {"fast_forward_pc",             required_argument, 0,  OPT_FAST_FORWARD_PC },
+            {"stats_file",                  required_argument, 0,  OPT_STATS_FILE },
+            {"cpu_layout",                        no_argument, 0,  OPT_CPU_LAYOUT },
 
             {"ignore_sbi_shutdown",         required_argument, 0,  'P' }, // CFG
             {"dump_memories",                     no_argument, 0,  'D' }, // CFG
@@ -175,6 +254,8 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
             {"ctrlc",                             no_argument, 0,  'X' },
 #ifdef LIVECACHE
             {"live_cache_size",             required_argument, 0,  'w' }, // CFG
+            {"live_cache_config",           required_argument, 0,  OPT_LIVE_CACHE_CONFIG },
+            {"live_cache_window",           required_argument, 0,  OPT_LIVE_CACHE_WINDOW },
 #endif
             {0,                                             0, 0,   0  }
         };
@@ -205,8 +286,12 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
 
             case 'i':
                 march_string = strdup(optarg);
+                march_given  = true;
                 break;
 
+            case OPT_VLEN: vlen = (uint64_t)atoll(optarg); break;
+            case OPT_ELEN: elen = (uint64_t)atoll(optarg); break;
+
             case 'I':
                 interactive = true;
                 break;
@@ -280,6 +365,27 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
             case 'v': simpoint_en_bbv = true; break;
             case 'F': simpoint_bb_file = strdup(optarg); break;
             case 'Y': simpoint_size = (uint64_t)atoll(optarg); break;
+            case OPT_SIMPOINT_ROI_AT_RESET: simpoint_roi_at_reset = true; break;
+            case OPT_SIMPOINT_CLUSTER: simpoint_cluster = true; break;
+            case OPT_SIMPOINT_AUTO: simpoint_auto = true; break;
+            case OPT_SIMPOINT_MAXK: simpoint_maxk = atoi(optarg); break;
+            case OPT_SIMPOINT_DIM: simpoint_dim = atoi(optarg); break;
+            case OPT_SIMPOINT_THREADS: simpoint_threads = atoi(optarg); break;
+            case OPT_SIMPOINT_OUT: simpoint_out = strdup(optarg); break;
+            case OPT_CHECKPOINT_ASYNC: checkpoint_async = atoi(optarg); break;
+            case OPT_WARMUP_RESTORE:
+                if (!strcmp(optarg, "preload")) {
+#ifndef LIVECACHE
+                    usage(prog, "--warmup_restore preload needs a build with -DLIVECACHE");
+#endif
+                    warmup_preload = true;
+                } else if (strcmp(optarg, "loop"))
+                    usage(prog, "--warmup_restore must be loop or preload");
+                break;
+            case OPT_FAST_FORWARD: ffwd_until_insns = (uint64_t)atoll(optarg); break;
+            case OPT_FAST_FORWARD_PC: ffwd_until_pc = strtoull(optarg, NULL, 0); break;
+            case OPT_STATS_FILE: stats_file = strdup(optarg); break;
+            case OPT_CPU_LAYOUT: cpu_layout = true; break;
 
             case 'P': ignore_sbi_shutdown = true; break;
             case 'D': dump_memories = true; break;
@@ -368,13 +474,21 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
                 {
                     char last = optarg[strlen(optarg) - 1];
                     if (last == 'k' || last == 'K')
-                        live_cache_size *= 1000;
+                        live_cache_size <<= 10;
                     else if (last == 'm' || last == 'M')
-                        live_cache_size *= 1000000;
+                        live_cache_size <<= 20;
                     else if (last == 'g' || last == 'G')
-                        live_cache_size *= 1000000000;
+                        live_cache_size <<= 30;
                 }
                 break;
+            case OPT_LIVE_CACHE_CONFIG:
+                if (live_cache_config)
+                    usage(prog, "already had a live_cache_config");
+                live_cache_config = strdup(optarg);
+                break;
+            case OPT_LIVE_CACHE_WINDOW:
+                live_cache_window = (uint64_t)atoll(optarg);
+                break;
 #endif
             case 'X':
                 allow_ctrlc = true;
@@ -543,14 +657,51 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
     p->custom_extension = custom_extension;
     p->clear_ids        = clear_ids;
 
+#if VLEN > 0
+    // Vector unit, --vlen/--elen over --march over the config file
+    march_vector_config(march_string, &p->vlen, &p->elen);
+    if (vlen)
+        p->vlen = vlen;
+    if (elen)
+        p->elen = elen;
+#endif
+
+    // Interpreter profile, every implemented extension without --march
+    if (march_given || show_enabled_extensions) {
+        if (!parse_isa_string(march_string, *isa_flags)) {
+            fprintf(stderr, "Parsing --march string failed\n");
+            exit(1);
+        }
+        p->isa_ext = isa_config_ext(*isa_flags);
+        if (isa_profile_index(p->isa_ext) < 0) {
+            fprintf(stderr, "--march %s matches no interpreter profile, "
+                    "see --help-march\n", march_string);
+            exit(1);
+        }
+    }
+
     RISCVMachine *s = virt_machine_init(p);
     if (!s)
         return NULL;
 
 #ifdef LIVECACHE
-    // LiveCache (should be ~2x larger than real LLC)
-    s->llc = new LiveCache("LiveCache", live_cache_size,
-                           p->ram_base_addr, p->ram_size);
+    // LiveCache, a described hierarchy or one level (should be ~2x larger
+    // than real LLC)
+    if (!live_cache_config)
+        live_cache_config = p->live_cache_config;
+
+    std::vector<LiveCacheLevelConfig> live_cache_levels;
+    if (live_cache_config) {
+        if (live_cache_size)
+            fprintf(majordomo_stderr, "-W: --live_cache_size is ignored with a live cache config\n");
+        if (!livecache_load_config(live_cache_config, live_cache_levels))
+            return NULL;
+    } else {
+        live_cache_levels = livecache_default_config(live_cache_size ? live_cache_size : 8 * 1024 * 1024);
+    }
+    s->llc       = new LiveCacheHierarchy(live_cache_levels, p->ram_base_addr, p->ram_size);
+    s->llc_track = true;
+    s->common.live_cache_window = live_cache_window;
 #endif
 
     if (elf_based) {
@@ -585,14 +736,9 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
         }
         int distance;
         int num;
+        s->common.simpoint_size = simpoint_size;  // needed by simpoint_add
         while (fscanf(file, "%d %d", &distance, &num) == 2) {
-            uint64_t start = distance * s->common.simpoint_size;
-
-            if (start == 0) {  // skip boot ROM
-                start = ROM_SIZE;
-            }
-
-            s->common.simpoints.push_back({start, num});
+            simpoint_add(&s->common, distance, num);
         }
 
         std::sort(s->common.simpoints.begin(), s->common.simpoints.end());
@@ -608,18 +754,12 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
         s->common.simpoint_next = 0;
     }
 
-    (void) march_string;
-//    //WTF: original code, s = RISCVMachine...
-//    if(!parse_isa_string(march_string,*isa_flags)) {
-//      fprintf(stderr, "Parsing --march string failed\n");
-//      exit(1);
-//    }
-//
-    (void) show_enabled_extensions;
-//    if(show_enabled_extensions) {
-//      printIsaConfigFlags(*isa_flags,false); //not verbose
-//      exit(1);
-//    }
+    if(show_enabled_extensions) {
+      printIsaConfigFlags(*isa_flags,false); //not verbose
+      fprintf(stderr, "Interpreter profile: %s\n",
+              isa_profiles[s->isa_profile].name);
+      exit(1);
+    }
 
     s->common.snapshot_save_name = snapshot_save_name;
     s->common.exe_trace          = exe_trace;
@@ -682,6 +822,31 @@ RISCVMachine *virt_machine_main(int argc, char **argv) {
     s->common.simpoint_en_bbv            = simpoint_en_bbv;
     s->common.simpoint_bb_file           = simpoint_bb_file;
     s->common.simpoint_size              = simpoint_size;
+    s->common.simpoint_roi_at_reset      = simpoint_roi_at_reset;
+    s->common.simpoint_cluster           = simpoint_cluster || simpoint_auto;
+    s->common.simpoint_auto              = simpoint_auto;
+    s->common.simpoint_maxk              = simpoint_maxk;
+    s->common.simpoint_dim               = simpoint_dim;
+    s->common.simpoint_threads           = simpoint_threads;
+    s->common.simpoint_out               = simpoint_out;
+    // Default to one writer per spare host cpu, at most 4
+    if (checkpoint_async < 0)
+        checkpoint_async = std::clamp((int)sysconf(_SC_NPROCESSORS_ONLN) - 1, 0, 4);
+    s->common.checkpoint_async           = checkpoint_async;
+    s->common.warmup_preload             = warmup_preload;
+
+    s->common.ffwd_until_insns           = ffwd_until_insns;
+    s->common.ffwd_until_pc              = ffwd_until_pc;
+    s->common.ffwd                       = ffwd_until_insns > 0 || ffwd_until_pc != UINT64_MAX;
+    s->common.stats_file                 = stats_file;
+    s->common.cpu_layout                 = cpu_layout;
+
+    // --simpoint_auto collects the bbvs itself
+    if (simpoint_auto) {
+        if (simpoint_file)
+            usage(prog, "--simpoint_auto and --simpoint are exclusive");
+        s->common.simpoint_en_bbv = true;
+    }
 
     // Allow the command option argument to overwrite the value
     // specified in the configuration file
@@ -724,6 +889,11 @@ void virt_machine_set_defaults(VirtMachineParams *p) {
     p->plic_size         = PLIC_SIZE;
     p->clint_base_addr   = CLINT_BASE_ADDR;
     p->clint_size        = CLINT_SIZE;
+#if VLEN > 0
+    p->vlen = VLEN;
+    p->elen = ELEN;
+#endif
+    p->isa_ext = ISA_PROFILE_ALL;
 }
 
 RISCVMachine *global_virt_machine = 0;
@@ -782,6 +952,21 @@ RISCVMachine *virt_machine_init(const VirtMachineParams *p) {
         return NULL;
     }
 
+#if VLEN > 0
+    if (!riscv_vector_config_ok(p->vlen, p->elen)) {
+        vm_error("ERROR: unsupported vlen:%d elen:%d\n", (int)p->vlen, (int)p->elen);
+        return NULL;
+    }
+    s->vlen = p->vlen;
+    s->elen = p->elen;
+#endif
+    s->isa_ext     = p->isa_ext;
+    s->isa_profile = isa_profile_index(p->isa_ext);
+    if (s->isa_profile < 0) {
+        vm_error("ERROR: no interpreter profile for ISA extensions 0x%x\n", (unsigned)p->isa_ext);
+        return NULL;
+    }
+
     for (int i = 0; i < s->ncpus; ++i) {
         s->cpu_state[i] = riscv_cpu_init(s, i);
     }
@@ -995,12 +1180,17 @@ void virt_machine_end(RISCVMachine *s) {
     if (s->common.snapshot_save_name)
         virt_machine_serialize(s, s->common.snapshot_save_name);
 
+    virt_machine_serialize_wait(s, 0);
+
     /* XXX: stop all */
     for (int i = 0; i < s->ncpus; ++i) {
         riscv_cpu_end(s->cpu_state[i]);
     }
 
     phys_mem_map_end(s->mem_map);
+#ifdef LIVECACHE
+    delete s->llc;
+#endif
     free(s);
 }
 
@@ -1011,6 +1201,124 @@ void virt_machine_serialize(RISCVMachine *m, const char *dump_name) {
 
     assert(m->ncpus == 1);  // FIXME: riscv_cpu_serialize must be patched for multicore
     riscv_cpu_serialize(s, dump_name, m->clint_base_addr);
+#ifdef LIVECACHE
+    m->llc->dump(dump_name);
+#endif
+}
+
+// Background checkpoint writers. fork() gives the child a copy-on-write
+// image of the whole machine, the child writes the checkpoint files while
+// the parent keeps executing. Each outstanding child holds on to the pages
+// the parent dirties afterwards, checkpoint_async bounds that cost.
+struct CheckpointWriter {
+    pid_t       pid;
+    std::string name;
+};
+
+static std::vector<CheckpointWriter> checkpoint_writers;
+
+void virt_machine_serialize_async(RISCVMachine *m, const char *dump_name) {
+    if (m->common.checkpoint_async <= 0) {
+        virt_machine_serialize(m, dump_name);
+        return;
+    }
+
+    virt_machine_serialize_wait(m, m->common.checkpoint_async - 1);
+
+    // Nothing buffered may be inherited, or it would be written twice
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(majordomo_stderr, "WARNING: fork failed, writing %s in the foreground\n", dump_name);
+        virt_machine_serialize(m, dump_name);
+        return;
+    }
+
+    if (pid == 0) {
+        virt_machine_serialize(m, dump_name);
+        fflush(NULL);
+        _exit(0);
+    }
+
+    checkpoint_writers.push_back({pid, dump_name});
+}
+
+// Block until at most max_outstanding writers are still running
+void virt_machine_serialize_wait(RISCVMachine *m, int max_outstanding) {
+    (void)m;
+    while ((int)checkpoint_writers.size() > std::max(max_outstanding, 0)) {
+        int   status = 0;
+        pid_t pid    = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            err(-3, "waiting for checkpoint writers");
+        }
+
+        auto it = std::find_if(checkpoint_writers.begin(), checkpoint_writers.end(),
+                               [pid](const CheckpointWriter &w) { return w.pid == pid; });
+        if (it == checkpoint_writers.end())
+            continue;
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(majordomo_stderr, "ERROR: checkpoint writer for %s failed\n", it->name.c_str());
+            exit(-3);
+        }
+        checkpoint_writers.erase(it);
+    }
+}
+
+// A WARMUP checkpoint carries its warm set in <dump_name>.warmup and a boot
+// ROM loop that replays it from WARMUP_BASE_ADDR. Map that region sized to
+// the whole set, or with a zero count when the warm set is pre-loaded into
+// the cache model instead or the side file is missing, the boot rom of a
+// LIVECACHE build reads the count either way.
+static void virt_machine_restore_warmup(RISCVMachine *m, const char *dump_name) {
+    std::string name    = std::string(dump_name) + ".warmup";
+    bool        missing = access(name.c_str(), R_OK) != 0;
+#ifndef LIVECACHE
+    if (missing)
+        return;
+#endif
+
+    std::vector<WarmupLevel> warm;
+    if (missing)
+        fprintf(majordomo_stderr, "warmup: %s not found, restoring with cold caches\n", name.c_str());
+    else if (!warmup_read(name.c_str(), warm))
+        exit(-3);
+
+    // preload is rejected at option parse without LIVECACHE
+    std::vector<uint64_t> list;
+    bool                  preloaded = false;
+#ifdef LIVECACHE
+    if (m->common.warmup_preload) {
+        m->llc->preload(warm);
+        preloaded = true;
+    }
+#endif
+    if (!preloaded)
+        list = warmup_replay_list(warm);
+
+    uint64_t size = (sizeof(uint64_t) * (list.size() + 1) + 4095) & ~(uint64_t)4095;
+    if (size > WARMUP_MAX_SIZE
+        || (m->ram_base_addr < WARMUP_BASE_ADDR + size && WARMUP_BASE_ADDR < m->ram_base_addr + m->ram_size)) {
+        fprintf(majordomo_stderr, "ERROR: the %zu line warm set does not fit at 0x%x\n", list.size(), WARMUP_BASE_ADDR);
+        exit(-3);
+    }
+
+    PhysMemoryRange *pr  = cpu_register_ram(m->mem_map, WARMUP_BASE_ADDR, size, 0);
+    uint64_t *       mem = (uint64_t *)pr->phys_mem;
+    mem[0]               = list.size();
+    memcpy(mem + 1, list.data(), sizeof(uint64_t) * list.size());
+
+    if (missing)
+        return;
+    fprintf(majordomo_stderr,
+            "warmup: %s, %zu levels, %s\n",
+            name.c_str(),
+            warm.size(),
+            preloaded ? "pre-loaded" : (std::to_string(list.size()) + " lines replayed by the boot rom").c_str());
 }
 
 void virt_machine_deserialize(RISCVMachine *m, const char *dump_name) {
@@ -1018,6 +1326,7 @@ void virt_machine_deserialize(RISCVMachine *m, const char *dump_name) {
 
     assert(m->ncpus == 1);  // FIXME: riscv_cpu_serialize must be patched for multicore
     riscv_cpu_deserialize(s, dump_name);
+    virt_machine_restore_warmup(m, dump_name);
 }
 
 int virt_machine_get_sleep_duration(RISCVMachine *m, int hartid, int ms_delay) {
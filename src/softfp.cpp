@@ -86,6 +86,9 @@ static inline int clz128(uint128_t a) {
 #endif
 
 #include "softfp.h"
+#include "softfp_host.h"
+
+bool softfp_host_fpu = true;
 
 #define F_SIZE 32
 #include "softfp_template.h"
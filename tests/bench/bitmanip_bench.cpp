@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Bitmanip host kernel check and benchmark.
+ *
+ * Runs orc.b, rev8, clmul, clmulh and clmulr on 32 and 64 bit operands
+ * through the host versions of bitmanip_host.h and the portable reference
+ * versions and compares the results. Operands are random bits, random
+ * bytes of 0x00/0xff/other and single bit patterns. Then times both.
+ *
+ *   md_bitmanip_bench [n]
+ *
+ * Exits 1 on the first mismatch.
+ */
+#include "bitmanip_host.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd() {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// kind 0: random bits, 1: bytes of 0x00, 0xff or random, 2: one or two bits
+static uint64_t rnd_op(int kind) {
+    uint64_t r = rnd();
+    switch (kind) {
+        case 0: return r;
+        case 1: {
+            uint64_t v = 0;
+            for (int i = 0; i < 8; ++i) {
+                uint64_t b = (r >> (i * 2)) & 3;
+                v |= (b == 0 ? 0 : b == 1 ? 0xff : (rnd() & 0xff)) << (i * 8);
+            }
+            return v;
+        }
+        default: return (uint64_t(1) << (r & 63)) | ((r >> 6) & 1 ? uint64_t(1) << ((r >> 7) & 63) : 0);
+    }
+}
+
+enum { OP_ORC_B, OP_REV8, OP_CLMUL, OP_CLMULH, OP_CLMULR, N_OPS };
+
+static const char *op_name[N_OPS] = {"orc.b", "rev8", "clmul", "clmulh", "clmulr"};
+
+template <class U>
+static U run(int op, bool host, U a, U b) {
+    switch (op) {
+        case OP_ORC_B: return host ? host_orc_b(a) : ref_orc_b(a);
+        case OP_REV8: return host ? host_rev8(a) : ref_rev8(a);
+        case OP_CLMUL: return host ? host_clmul(a, b) : ref_clmul(a, b);
+        case OP_CLMULH: return host ? host_clmulh(a, b) : ref_clmulh(a, b);
+        default: return host ? host_clmulr(a, b) : ref_clmulr(a, b);
+    }
+}
+
+template <class U>
+static bool check(const char *type, int n) {
+    for (int i = 0; i < n; ++i) {
+        int kind = rnd() % 3;
+        U   a = U(rnd_op(kind)), b = U(rnd_op(kind));
+        int op = i % N_OPS;
+
+        U ref  = run<U>(op, false, a, b);
+        U host = run<U>(op, true, a, b);
+        if (ref != host) {
+            printf("FAIL %s %s a=%" PRIx64 " b=%" PRIx64 ": ref %" PRIx64 " host %" PRIx64 "\n", type, op_name[op],
+                   (uint64_t)a, (uint64_t)b, (uint64_t)ref, (uint64_t)host);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class U>
+static double time_op(int op, const std::vector<U> &v, bool host) {
+    U    sum = 0;
+    auto t0  = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + 1 < v.size(); ++i) sum ^= run<U>(op, host, v[i], v[i + 1] ^ sum);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (sum == 1)  // keep the loop
+        printf(" ");
+    return 1e-6 * (v.size() - 1) / secs;
+}
+
+template <class U>
+static void bench(const char *type, int n) {
+    std::vector<U> v(n);
+    for (auto &x : v) x = U(rnd());
+
+    for (int op = 0; op < N_OPS; ++op) {
+        double ref  = time_op(op, v, false);
+        double host = time_op(op, v, true);
+        printf("%s %-6s ref %8.2f Mops/s host %8.2f Mops/s %6.2fx\n", type, op_name[op], ref, host, host / ref);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    if (!check<uint32_t>("u32", n) || !check<uint64_t>("u64", n))
+        return 1;
+#ifdef BITMANIP_HOST_X86
+    printf("u32/u64 %d ops per type match the reference, pclmul %s\n", n, host_has_pclmul() ? "yes" : "no");
+#else
+    printf("u32/u64 %d ops per type match the reference\n", n);
+#endif
+
+    bench<uint32_t>("u32", n);
+    bench<uint64_t>("u64", n);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Cosim step loop benchmark for md_bench.
+ *
+ * Drives majordomo_cosim_step() one instruction at a time with checking
+ * disabled, the way a DUT testbench without a reference trace would, and
+ * reports the step rate. Use --maxinsns to bound bare metal programs that
+ * spin after writing tohost. With --array n the steps go through
+ * majordomo_cosim_step_array(), n commits per call. With --async depth
+ * they are checked on a separate thread through a queue of that depth.
+ *
+ *   md_cosim_step_bench [--array n] [--async depth] <majordomo args> <elf>
+ *
+ * The result is one line on stdout:
+ *
+ *   md_bench {"instructions": N, "init_seconds": S, "wall_seconds": S,
+ *             "mips": M, "steps_per_second": R, "peak_rss_kib": K}
+ */
+#include "cutils.h"
+#include "majordomo_cosim.h"
+#include "majordomo_protos.h"
+#include "options.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+Options *Options::instance = 0;
+std::shared_ptr<Options> opts(Options::getInstance());
+
+// A testbench normally routes the per step log somewhere cheap, keep it
+// out of the measurement
+static void quiet_log(int hartid, const char *fmt, ...) {}
+
+int main(int argc, char *argv[]) {
+    majordomo_stdout = stdout;
+    majordomo_stderr = stderr;
+
+    int array = 0, async = 0;
+    while (argc > 2 && (strcmp(argv[1], "--array") == 0 || strcmp(argv[1], "--async") == 0)) {
+        (strcmp(argv[1], "--array") == 0 ? array : async) = atoi(argv[2]);
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+
+    double t0 = get_current_time_in_seconds();
+
+    majordomo_cosim_state_t *s = majordomo_cosim_init(argc, argv);
+    if (!s)
+        return 1;
+    majordomo_install_new_loggers(s, &quiet_log, &majordomo_default_error_log);
+    if (async > 0 && majordomo_cosim_async_start(s, async))
+        return 1;
+
+    double t1 = get_current_time_in_seconds();
+
+    uint64_t n = 0;
+    if (array > 0) {
+        std::vector<majordomo_cosim_commit_t> commits(array);
+        int                                   done = array;
+        while (done == array) {
+            majordomo_cosim_step_array(s, 0, commits.data(), array, false, &done);
+            n += done;
+        }
+    } else {
+        while (!majordomo_cosim_step(s, 0, 0, 0, 0, 0, false))
+            ++n;
+    }
+
+    // The step results lag the checker, the drain gives the exact count
+    if (async > 0) {
+        uint64_t fail_index = n;
+        majordomo_cosim_async_stop(s, &fail_index);
+        n = fail_index;
+    }
+
+    double t2 = get_current_time_in_seconds();
+
+    majordomo_cosim_fini(s);
+
+    double rate = t2 > t1 ? n / (t2 - t1) : 0.0;
+    printf("md_bench {\"instructions\": %" PRIu64 ", \"init_seconds\": %.6f, "
+           "\"wall_seconds\": %.6f, \"mips\": %.3f, \"steps_per_second\": %.0f, "
+           "\"peak_rss_kib\": %ld}\n",
+           n, t1 - t0, t2 - t1, 1e-6 * rate, rate, get_peak_rss_kib());
+    return 0;
+}
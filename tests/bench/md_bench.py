@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2024, Jeff Nye
+#
+# Licensed under the Apache License, Version 2.0 (the "License")
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# md_bench: run the checked in ELFs under each majordomo mode and record
+# MIPS, peak RSS and startup time to a JSON file.
+#
+# Instruction counts and run time come from majordomo's --stats_file, so
+# MIPS excludes startup. Startup is the rest of the process wall time
+# (exec, memory allocation, ELF load, teardown). Peak RSS is reported by
+# the child itself, wait4() would include the forked interpreter. Each
+# point is the best of --repeat runs (highest MIPS, lowest startup), host
+# noise only ever slows a run down.
+#
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+TOP = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+DEFAULT_ELFS = [
+    os.path.join(TOP, 'tests', 'elfs', 'bmi_mm.bare.riscv'),
+    os.path.join(TOP, 'examples', 'rvt_mm.bare.elf'),
+]
+
+MODES = ['plain', 'stf', 'bbv', 'livecache', 'cosim']
+
+
+# ---------------------------------------------------------------------------
+# Extra majordomo arguments per mode, files go to the scratch directory
+# ---------------------------------------------------------------------------
+def mode_args(mode, tmp):
+    if mode == 'plain':
+        return []
+    if mode == 'stf':
+        return ['--stf_trace', os.path.join(tmp, 'md_bench.zstf')]
+    if mode == 'bbv':
+        return ['--simpoint_en_bbv', '--simpoint_roi_at_reset',
+                '--simpoint_size', '100000',
+                '--simpoint_bb_file', os.path.join(tmp, 'md_bench.bb')]
+    if mode == 'livecache':
+        return ['--live_cache_size', '8M']
+    return []
+
+
+# ---------------------------------------------------------------------------
+# Run one command, return (exit code, wall seconds, stdout)
+# ---------------------------------------------------------------------------
+def run(cmd, cwd):
+    t0 = time.perf_counter()
+    p = subprocess.run(cmd, cwd=cwd, stdin=subprocess.DEVNULL,
+                       stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    wall = time.perf_counter() - t0
+    return p.returncode, wall, p.stdout.decode(errors='replace')
+
+
+def run_once(args, elf, mode, insns, tmp):
+    base = ['--ctrlc']
+
+    if mode == 'cosim':
+        # The step loop does not watch tohost, stop where the plain run did
+        cmd = [args.cosim_bench] + base + ['--maxinsns', str(insns), elf]
+        rc, wall, out = run(cmd, tmp)
+        line = [l for l in out.splitlines() if l.startswith('md_bench ')]
+        if rc != 0 or not line:
+            return None
+        stats = json.loads(line[-1][len('md_bench '):])
+    else:
+        stats_file = os.path.join(tmp, 'md_bench_stats.json')
+        if os.path.exists(stats_file):
+            os.remove(stats_file)
+        cmd = [args.majordomo] + base + ['--stats_file', stats_file] \
+              + mode_args(mode, tmp) + [elf]
+        rc, wall, _ = run(cmd, tmp)
+        if rc != 0 or not os.path.exists(stats_file):
+            return None
+        with open(stats_file) as f:
+            stats = json.load(f)
+
+    return {
+        'instructions':    stats['instructions'],
+        'mips':            stats['mips'],
+        'peak_rss_kib':    stats['peak_rss_kib'],
+        'startup_seconds': max(0.0, wall - stats['wall_seconds']),
+        'wall_seconds':    wall,
+    }
+
+
+def best_of(runs):
+    return {
+        'mips':            max(r['mips'] for r in runs),
+        'peak_rss_kib':    statistics.median(r['peak_rss_kib'] for r in runs),
+        'startup_seconds': min(r['startup_seconds'] for r in runs),
+        'wall_seconds':    min(r['wall_seconds'] for r in runs),
+    }
+
+
+def main():
+    ap = argparse.ArgumentParser(description='majordomo performance benchmark')
+    ap.add_argument('--majordomo', required=True, help='majordomo binary')
+    ap.add_argument('--cosim-bench', help='md_cosim_step_bench binary, enables the cosim mode')
+    ap.add_argument('--warmup', action='store_true',
+                    help='majordomo is a WARMUP (LiveCache) build, enables the livecache mode')
+    ap.add_argument('--elf', action='append', help='ELF to run, repeatable (default: checked in set)')
+    ap.add_argument('--modes', default=','.join(MODES), help='comma separated subset of ' + ','.join(MODES))
+    ap.add_argument('--repeat', type=int, default=5, help='runs per point, the best is kept')
+    ap.add_argument('--out', default='md_bench.json', help='results file')
+    args = ap.parse_args()
+
+    elfs  = args.elf or DEFAULT_ELFS
+    modes = [m for m in args.modes.split(',') if m]
+    for m in modes:
+        if m not in MODES:
+            sys.exit('md_bench: unknown mode %s' % m)
+
+    results = []
+    skipped = []
+    failed  = 0
+
+    with tempfile.TemporaryDirectory(prefix='md_bench.') as tmp:
+        for elf in elfs:
+            name  = os.path.basename(elf)
+            insns = None
+            for mode in modes:
+                if mode == 'livecache' and not args.warmup:
+                    skipped.append({'elf': name, 'mode': mode, 'reason': 'not a WARMUP build'})
+                    continue
+                if mode == 'cosim' and not args.cosim_bench:
+                    skipped.append({'elf': name, 'mode': mode, 'reason': 'no --cosim-bench'})
+                    continue
+                if mode == 'cosim' and insns is None:
+                    r = run_once(args, elf, 'plain', 0, tmp)
+                    insns = r['instructions'] if r else 0
+
+                # One discarded run first, so page cache and branch
+                # predictor state do not land in the first sample
+                run_once(args, elf, mode, insns, tmp)
+
+                runs = []
+                for _ in range(max(1, args.repeat)):
+                    r = run_once(args, elf, mode, insns, tmp)
+                    if r is None:
+                        break
+                    runs.append(r)
+
+                if len(runs) < max(1, args.repeat):
+                    print('md_bench: %-22s %-10s FAILED' % (name, mode))
+                    failed += 1
+                    continue
+
+                if mode == 'plain':
+                    insns = runs[0]['instructions']
+
+                point = {'elf': name, 'mode': mode, 'instructions': runs[0]['instructions']}
+                point.update(best_of(runs))
+                results.append(point)
+
+                print('md_bench: %-22s %-10s %10d insns %8.2f MIPS %8d KiB %8.4fs startup'
+                      % (name, mode, point['instructions'], point['mips'],
+                         point['peak_rss_kib'], point['startup_seconds']))
+
+    report = {
+        'majordomo': os.path.abspath(args.majordomo),
+        'host':      platform.node(),
+        'machine':   platform.machine(),
+        'cpus':      os.cpu_count(),
+        'repeat':    args.repeat,
+        'date':      time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'results':   results,
+        'skipped':   skipped,
+    }
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+        f.write('\n')
+    print('md_bench: wrote %s' % args.out)
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2024, Jeff Nye
+#
+# Licensed under the Apache License, Version 2.0 (the "License")
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Compare md_bench results against a stored baseline.
+#
+#   md_bench_compare.py <baseline.json> <results.json>
+#
+# A point regresses when MIPS drops, or peak RSS or startup time grows, by
+# more than the tolerance. Startup also has an absolute floor so sub
+# millisecond jitter on short runs is not reported. Exits 1 on regression.
+# A missing baseline is not an error, store one with md_bench_baseline.
+#
+import argparse
+import json
+import os
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        r = json.load(f)
+    return {(p['elf'], p['mode']): p for p in r['results']}, r
+
+
+def main():
+    ap = argparse.ArgumentParser(description='compare md_bench results to a baseline')
+    ap.add_argument('baseline')
+    ap.add_argument('results')
+    ap.add_argument('--mips-tol', type=float, default=0.10, help='allowed MIPS drop (fraction)')
+    ap.add_argument('--rss-tol', type=float, default=0.10, help='allowed peak RSS growth (fraction)')
+    ap.add_argument('--startup-tol', type=float, default=0.20, help='allowed startup growth (fraction)')
+    ap.add_argument('--startup-floor', type=float, default=0.005,
+                    help='startup growth below this many seconds is ignored')
+    args = ap.parse_args()
+
+    if not os.path.exists(args.baseline):
+        print('md_bench_compare: no baseline at %s, nothing to compare' % args.baseline)
+        return 0
+
+    base, base_report = load(args.baseline)
+    cur,  cur_report  = load(args.results)
+
+    if base_report.get('host') != cur_report.get('host'):
+        print('md_bench_compare: warning, baseline is from host %s, results from %s'
+              % (base_report.get('host'), cur_report.get('host')))
+
+    regressions = 0
+    print('%-22s %-10s %10s %10s %8s %10s %10s' % ('elf', 'mode', 'MIPS base', 'MIPS now', 'delta',
+                                                 'RSS delta', 'startup'))
+    for key in sorted(cur):
+        c = cur[key]
+        b = base.get(key)
+        if b is None:
+            print('%-22s %-10s %10s %10.2f   (new)' % (key[0], key[1], '-', c['mips']))
+            continue
+
+        flags = []
+        d_mips = (c['mips'] - b['mips']) / b['mips'] if b['mips'] else 0.0
+        d_rss  = (c['peak_rss_kib'] - b['peak_rss_kib']) / b['peak_rss_kib'] if b['peak_rss_kib'] else 0.0
+        d_su   = c['startup_seconds'] - b['startup_seconds']
+
+        if d_mips < -args.mips_tol:
+            flags.append('MIPS')
+        if d_rss > args.rss_tol:
+            flags.append('RSS')
+        if d_su > args.startup_floor and d_su > args.startup_tol * b['startup_seconds']:
+            flags.append('STARTUP')
+        if c['instructions'] != b['instructions']:
+            flags.append('INSNS %d != %d' % (c['instructions'], b['instructions']))
+
+        print('%-22s %-10s %10.2f %10.2f %+7.1f%% %+9.1f%% %+9.4fs %s'
+              % (key[0], key[1], b['mips'], c['mips'], 100 * d_mips, 100 * d_rss, d_su,
+                 ('REGRESSION ' + ','.join(flags)) if flags else ''))
+        if flags:
+            regressions += 1
+
+    for key in sorted(set(base) - set(cur)):
+        print('%-22s %-10s missing from results' % key)
+
+    if regressions:
+        print('md_bench_compare: %d regression(s)' % regressions)
+        return 1
+    print('md_bench_compare: no regressions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Binary128 (Q extension) check and benchmark.
+ *
+ * Runs add, mul, div, sqrt and fma in binary128 under every rounding mode,
+ * once through softfp alone and once with the host FPU path, and compares
+ * result bits and fflags. Operands are normals of moderate magnitude,
+ * random bits, small integers, squares of short values (exact div and
+ * sqrt) and values near the ends of the fast path exponent range, half of
+ * the ops starting from random sticky fflags. Then times the moderate
+ * normals both ways, and a dot product and a Newton step kernel built
+ * from them, the way an FLEN=128 build runs fadd.q..fsqrt.q.
+ *
+ *   md_quad_bench [n]
+ *
+ * Exits 1 on the first mismatch.
+ */
+#include "softfp.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd() {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+static const sfloat128 SIGN = (uint128_t)1 << 127;
+
+static sfloat128 mk_f128(uint64_t sign, uint64_t exp, uint128_t mant) {
+    return (uint128_t)sign << 127 | (uint128_t)(exp & 0x7fff) << 112 | (mant & (((uint128_t)1 << 112) - 1));
+}
+
+// kind 0: normals of moderate magnitude, 1: random bits, 2: small integers,
+// 3: a short significand, 4: exponents near the ends of the host fast path
+// range
+static sfloat128 rnd_f128(int kind) {
+    uint64_t  r    = rnd();
+    uint128_t mant = (uint128_t)rnd() << 64 | rnd();
+    uint32_t  f    = 0;
+    int       w    = 1 + (r >> 8) % 56;
+    switch (kind) {
+        case 0: return mk_f128(r >> 63, 16383 - 100 + r % 200, mant);
+        case 1: return mant;
+        case 2: return cvt_i32_sf128(int(r % 64) - 32, RM_RNE, &f);
+        case 3: return mk_f128(r >> 63, 16383 - 8 + r % 16, mant >> (128 - w) << (112 - w));
+        default: return mk_f128(r >> 63, r & 1 ? 200 + (r >> 1) % 60 : 32700 + (r >> 1) % 67, mant);
+    }
+}
+
+enum { OP_ADD, OP_MUL, OP_DIV, OP_SQRT, OP_FMA, N_OPS };
+
+static const char *op_name[N_OPS] = {"add", "mul", "div", "sqrt", "fma"};
+
+static sfloat128 run(int op, sfloat128 a, sfloat128 b, sfloat128 c, RoundingModeEnum rm, uint32_t *f) {
+    switch (op) {
+        case OP_ADD: return add_sf128(a, b, rm, f);
+        case OP_MUL: return mul_sf128(a, b, rm, f);
+        case OP_DIV: return div_sf128(a, b, rm, f);
+        case OP_SQRT: return sqrt_sf128(a, rm, f);
+        default: return fma_sf128(a, b, c, rm, f);
+    }
+}
+
+static bool check(int n) {
+    for (int i = 0; i < n; ++i) {
+        int              kind = rnd() % 5;
+        sfloat128        a = rnd_f128(kind), b = rnd_f128(kind), c = rnd_f128(kind);
+        int              op = i % N_OPS;
+        RoundingModeEnum rm = RoundingModeEnum((i / N_OPS) % 5);
+
+        uint32_t f = 0;
+        if (kind == 3 && op == OP_DIV && rnd() & 1)  // a multiple of b
+            a = mul_sf128(b, rnd_f128(3), RM_RNE, &f);
+        if (kind == 3 && op == OP_SQRT)  // a square
+            a = mul_sf128(b & ~SIGN, b & ~SIGN, RM_RNE, &f);
+
+        uint32_t ref_f = rnd() & 1 ? rnd() & 0x1f : 0, host_f = ref_f;
+        softfp_host_fpu = false;
+        sfloat128 ref   = run(op, a, b, c, rm, &ref_f);
+        softfp_host_fpu = true;
+        sfloat128 host  = run(op, a, b, c, rm, &host_f);
+
+        if (ref != host || ref_f != host_f) {
+            printf("FAIL f128 %s rm=%d a=%016" PRIx64 "%016" PRIx64 " b=%016" PRIx64 "%016" PRIx64
+                   ": softfp %016" PRIx64 "%016" PRIx64 "/%x host %016" PRIx64 "%016" PRIx64 "/%x\n",
+                   op_name[op], rm, (uint64_t)(a >> 64), (uint64_t)a, (uint64_t)(b >> 64), (uint64_t)b,
+                   (uint64_t)(ref >> 64), (uint64_t)ref, ref_f, (uint64_t)(host >> 64), (uint64_t)host, host_f);
+            return false;
+        }
+    }
+    return true;
+}
+
+static double time_op(int op, const std::vector<sfloat128> &v, bool host) {
+    softfp_host_fpu = host;
+
+    uint32_t  f   = 0;
+    sfloat128 sum = 0;
+    auto      t0  = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + 2 < v.size(); ++i) sum ^= run(op, v[i], v[i + 1], v[i + 2], RM_RNE, &f);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (sum == 1)  // keep the loop
+        printf(" ");
+    return 1e-6 * (v.size() - 2) / secs;
+}
+
+// sum x[i] * y[i] with fma, then |x| with a sqrt and a Newton step
+// r = (r + x[i] / r) / 2 per element
+static double time_kernel(int k, const std::vector<sfloat128> &v, bool host) {
+    softfp_host_fpu = host;
+
+    uint32_t        f    = 0;
+    const sfloat128 one  = cvt_i32_sf128(1, RM_RNE, &f);
+    const sfloat128 half = one - ((uint128_t)1 << 112);
+    sfloat128       acc  = 0;
+    auto            t0   = std::chrono::steady_clock::now();
+    if (k == 0) {
+        for (size_t i = 0; i + 1 < v.size(); ++i) acc = fma_sf128(v[i], v[i + 1], acc, RM_RNE, &f);
+        acc = sqrt_sf128(acc & ~SIGN, RM_RNE, &f);
+    } else {
+        sfloat128 r = one;
+        for (size_t i = 0; i + 1 < v.size(); ++i) {
+            sfloat128 x = v[i] & ~SIGN;
+            r           = mul_sf128(add_sf128(r, div_sf128(x, r, RM_RNE, &f), RM_RNE, &f), half, RM_RNE, &f);
+        }
+        acc = r;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (acc == 1)  // keep the loop
+        printf(" ");
+    return 1e-6 * (v.size() - 1) / secs;
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    if (!check(n))
+        return 1;
+    printf("f128 %d ops match softfp\n", n);
+
+    std::vector<sfloat128> v(n / 10);
+    for (auto &x : v) x = rnd_f128(0);
+
+    for (int op = 0; op < N_OPS; ++op) {
+        double soft = time_op(op, v, false);
+        double host = time_op(op, v, true);
+        printf("f128 %-4s softfp %7.2f Mops/s host %7.2f Mops/s %5.2fx\n", op_name[op], soft, host, host / soft);
+    }
+
+    static const char *kernel_name[] = {"dot+sqrt", "newton"};
+    for (int k = 0; k < 2; ++k) {
+        double soft = time_kernel(k, v, false);
+        double host = time_kernel(k, v, true);
+        printf("f128 %-8s softfp %7.2f Melem/s host %7.2f Melem/s %5.2fx\n", kernel_name[k], soft, host, host / soft);
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * softfp host FPU fast path check and benchmark.
+ *
+ * Runs add, sub, mul, div, sqrt and fma in binary32 and binary64 under
+ * every rounding mode, once through softfp alone and once with the host
+ * FPU path, and compares result bits and fflags. Operands are normals of
+ * moderate magnitude, random bits (NaNs, infinities, subnormals), small
+ * integers (exact results) and values near the ends of the fast path
+ * exponent range. Half of the ops start from random sticky fflags, to
+ * cover the host paths that skip the inexact test once it is set. Then
+ * times the moderate normals both ways, fflags accumulating as in a
+ * program.
+ *
+ *   md_softfp_bench [n]
+ *
+ * Exits 1 on the first mismatch.
+ */
+#include "softfp.h"
+
+#include <bit>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd() {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// kind 0: normals of moderate magnitude, 1: random bits, 2: small integers,
+// 3: exponents near the ends of the host fast path range
+static uint32_t rnd_f32(int kind) {
+    uint64_t r = rnd();
+    switch (kind) {
+        case 0: return (r & 0x807fffff) | (uint32_t(127 - 20 + (r >> 40) % 40) << 23);
+        case 1: return r >> 32;
+        case 2: return std::bit_cast<uint32_t>(float(int(r % 64) - 32));
+        default: return (r & 0x807fffff) | (uint32_t(r & (1ull << 40) ? 40 + (r >> 41) % 20 : 230 + (r >> 41) % 25) << 23);
+    }
+}
+
+static uint64_t rnd_f64(int kind) {
+    uint64_t r = rnd();
+    switch (kind) {
+        case 0: return (r & 0x800fffffffffffffull) | (uint64_t(1023 - 40 + (r >> 52) % 80) << 52);
+        case 1: return r;
+        case 2: return std::bit_cast<uint64_t>(double(int(r % 64) - 32));
+        default: return (r & 0x800fffffffffffffull) | (uint64_t(r & 1 ? 95 + (r >> 52) % 25 : 1930 + (r >> 52) % 117) << 52);
+    }
+}
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_SQRT, OP_FMA, N_OPS };
+
+static const char *op_name[N_OPS] = {"add", "sub", "mul", "div", "sqrt", "fma"};
+
+static uint32_t run32(int op, uint32_t a, uint32_t b, uint32_t c, RoundingModeEnum rm, uint32_t *f) {
+    switch (op) {
+        case OP_ADD: return add_sf32(a, b, rm, f);
+        case OP_SUB: return sub_sf32(a, b, rm, f);
+        case OP_MUL: return mul_sf32(a, b, rm, f);
+        case OP_DIV: return div_sf32(a, b, rm, f);
+        case OP_SQRT: return sqrt_sf32(a, rm, f);
+        default: return fma_sf32(a, b, c, rm, f);
+    }
+}
+
+static uint64_t run64(int op, uint64_t a, uint64_t b, uint64_t c, RoundingModeEnum rm, uint32_t *f) {
+    switch (op) {
+        case OP_ADD: return add_sf64(a, b, rm, f);
+        case OP_SUB: return sub_sf64(a, b, rm, f);
+        case OP_MUL: return mul_sf64(a, b, rm, f);
+        case OP_DIV: return div_sf64(a, b, rm, f);
+        case OP_SQRT: return sqrt_sf64(a, rm, f);
+        default: return fma_sf64(a, b, c, rm, f);
+    }
+}
+
+template <class T, class Run>
+static bool check(const char *type, int n, T (*gen)(int), Run run) {
+    for (int i = 0; i < n; ++i) {
+        int              kind = rnd() % 4;
+        T                a = gen(kind), b = gen(kind), c = gen(kind);
+        int              op = i % N_OPS;
+        RoundingModeEnum rm = RoundingModeEnum((i / N_OPS) % 5);
+
+        uint32_t ref_f = rnd() & 1 ? rnd() & 0x1f : 0, host_f = ref_f;
+        softfp_host_fpu = false;
+        T ref           = run(op, a, b, c, rm, &ref_f);
+        softfp_host_fpu = true;
+        T host          = run(op, a, b, c, rm, &host_f);
+
+        if (ref != host || ref_f != host_f) {
+            printf("FAIL %s %s rm=%d a=%" PRIx64 " b=%" PRIx64 " c=%" PRIx64 ": softfp %" PRIx64 "/%x host %" PRIx64 "/%x\n",
+                   type, op_name[op], rm, (uint64_t)a, (uint64_t)b, (uint64_t)c, (uint64_t)ref, ref_f, (uint64_t)host, host_f);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class Run>
+static double time_op(int op, const std::vector<T> &v, bool host, Run run) {
+    softfp_host_fpu = host;
+
+    uint32_t f   = 0;
+    T        sum = 0;
+    auto     t0  = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + 2 < v.size(); ++i)
+        sum ^= run(op, v[i], v[i + 1], v[i + 2], RM_RNE, &f);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (sum == 1)  // keep the loop
+        printf(" ");
+    return 1e-6 * (v.size() - 2) / secs;
+}
+
+template <class T, class Run>
+static void bench(const char *type, int n, T (*gen)(int), Run run) {
+    std::vector<T> v(n);
+    for (auto &x : v) x = gen(0);
+
+    for (int op = 0; op < N_OPS; ++op) {
+        double soft = time_op(op, v, false, run);
+        double host = time_op(op, v, true, run);
+        printf("%s %-4s softfp %7.2f Mops/s host %7.2f Mops/s %5.2fx\n", type, op_name[op], soft, host, host / soft);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    if (!check<uint32_t>("f32", n, rnd_f32, run32) || !check<uint64_t>("f64", n, rnd_f64, run64))
+        return 1;
+    printf("f32/f64 %d ops per type match softfp\n", n);
+
+    bench<uint32_t>("f32", n, rnd_f32, run32);
+    bench<uint64_t>("f64", n, rnd_f64, run64);
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2024, Jeff Nye
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Vector group kernel check and benchmark.
+ *
+ * Runs vadd, vwaddu, vwadd, vwaddu.w and vwadd.w at every SEW, .vv and
+ * .vx, masked and unmasked, over random register groups and vstart values,
+ * through the group kernels of vector_group.h and through a plain element
+ * loop, and compares the whole register file. Then times both on full
+ * LMUL=8 groups.
+ *
+ *   md_vector_bench [vlen] [n]
+ *
+ * Exits 1 on the first mismatch.
+ */
+#include "vector_group.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd() {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+struct Op {
+    const char *name;
+    Vector_Group_Op (*config)(uint8_t, bool, bool);
+    bool signed_src;
+    int  d_mul, s2_mul;
+};
+
+static const Op ops[] = {
+    {"vadd", vg_add_config<false, 1, 1>, false, 1, 1},
+    {"vwaddu", vg_add_config<false, 2, 1>, false, 2, 1},
+    {"vwadd", vg_add_config<true, 2, 1>, true, 2, 1},
+    {"vwaddu.w", vg_add_config<false, 2, 2>, false, 2, 2},
+    {"vwadd.w", vg_add_config<true, 2, 2>, true, 2, 2},
+};
+
+static uint64_t ext(uint64_t v, int bits, bool sign) {
+    if (bits == 64)
+        return v;
+    v &= (uint64_t(1) << bits) - 1;
+    if (sign && v >> (bits - 1))
+        v |= ~uint64_t(0) << bits;
+    return v;
+}
+
+static uint64_t load(const uint8_t *p, unsigned e, int bits, bool sign) {
+    uint64_t v = 0;
+    memcpy(&v, p + e * (bits / 8), bits / 8);
+    return ext(v, bits, sign);
+}
+
+// The element loop of vectorize_arithmetic on flat groups
+static void ref_add(const Op &op, int sew, uint8_t *vd, const uint8_t *vs2, const uint8_t *vs1, uint64_t x,
+                    const uint8_t *v0, unsigned e, unsigned end) {
+    for (; e < end; ++e) {
+        if (v0 && !(v0[e / 8] >> e % 8 & 1))
+            continue;
+        uint64_t a = load(vs2, e, sew * op.s2_mul, op.signed_src);
+        uint64_t b = vs1 ? load(vs1, e, sew, op.signed_src) : ext(x, sew, op.signed_src);
+        uint64_t r = a + b;
+        memcpy(vd + e * (sew * op.d_mul / 8), &r, sew * op.d_mul / 8);
+    }
+}
+
+static bool check(int vlen, int n) {
+    int                  vlenb = vlen / 8;
+    std::vector<uint8_t> ref(32 * vlenb), got(32 * vlenb);
+
+    for (int i = 0; i < n; ++i) {
+        const Op &op   = ops[rnd() % 5];
+        int       sew  = 8 << rnd() % (op.d_mul == 2 ? 3 : 4);
+        bool      vv   = rnd() & 1;
+        bool      vm   = rnd() & 1;
+        int       lmul = 1 << rnd() % 4;  // of vd, vd in v8-v15, sources in v16-v31
+        unsigned  end  = lmul * vlenb / (sew * op.d_mul / 8);
+        unsigned  start = rnd() % 4 ? 0 : rnd() % (end + 1);
+        uint64_t  x     = rnd();
+        int       vs2   = 16 + (rnd() % 2) * 8;
+        int       vs1   = vs2 ^ 8;
+
+        for (auto &b : ref) b = rnd();
+        got = ref;
+
+        Vector_Group_Op g = op.config(sew, vv, vm);
+        g(&got[8 * vlenb], &got[vs2 * vlenb], vv ? &got[vs1 * vlenb] : NULL, x, vm ? NULL : &got[0], start, end);
+        ref_add(op, sew, &ref[8 * vlenb], &ref[vs2 * vlenb], vv ? &ref[vs1 * vlenb] : NULL, x, vm ? NULL : &ref[0], start,
+                end);
+
+        if (ref != got) {
+            printf("FAIL %s.%s sew=%d lmul=%d vm=%d vstart=%u\n", op.name, vv ? "vv" : "vx", sew, lmul, vm, start);
+            return false;
+        }
+    }
+    return true;
+}
+
+static double time_op(const Op &op, int sew, bool vv, bool vm, int vlen, int n, bool group) {
+    int                  vlenb = vlen / 8;
+    std::vector<uint8_t> vr(32 * vlenb);
+    for (auto &b : vr) b = rnd();
+
+    unsigned        end = 8 * vlenb / (sew * op.d_mul / 8);
+    Vector_Group_Op g   = op.config(sew, vv, vm);
+    const uint8_t  *vs1 = vv ? &vr[24 * vlenb] : NULL;
+    const uint8_t  *v0  = vm ? NULL : &vr[0];
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        if (group)
+            g(&vr[8 * vlenb], &vr[16 * vlenb], vs1, i, v0, 0, end);
+        else
+            ref_add(op, sew, &vr[8 * vlenb], &vr[16 * vlenb], vs1, i, v0, 0, end);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (vr[8 * vlenb] == 1 && vr[9 * vlenb] == 2)  // keep the loop
+        printf(" ");
+    return 1e-6 * end * n / secs;
+}
+
+int main(int argc, char *argv[]) {
+    int vlen = argc > 1 ? atoi(argv[1]) : 512;
+    int n    = argc > 2 ? atoi(argv[2]) : 200000;
+
+    if (vlen < 64 || (vlen & (vlen - 1))) {
+        printf("vlen must be a power of 2 of at least 64\n");
+        return 1;
+    }
+
+    if (!check(vlen, n))
+        return 1;
+    printf("%d random ops match the element loop, VLEN=%d, %d byte host vectors\n", n, vlen, VG_BYTES);
+
+    for (auto &op : ops)
+        for (int sew = 8; sew * op.d_mul <= 64; sew <<= 1)
+            for (int vm = 1; vm >= 0; --vm) {
+                double elm   = time_op(op, sew, true, vm, vlen, n / 20, false);
+                double group = time_op(op, sew, true, vm, vlen, n / 20, true);
+                printf("%-8s e%-2d %-6s element %8.1f Melem/s group %8.1f Melem/s %5.2fx\n", op.name, sew,
+                       vm ? "" : "masked", elm, group, group / elm);
+            }
+
+    return 0;
+}